@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "geo/Sphere.h"
+#include "renderer/Frustum.h"
+#include "renderer/InstanceAttributes.h"
+#include "renderer/InstanceGrid.h"
+#include "utils/RadixSort.h"
+#include "utils/ThreadPool.h"
+
+// Microbenchmarks of the CPU kernels behind a frame: sphere generation, the instance grid,
+// frustum culling and the radix sort, each across sizes. Prints the median of several runs,
+// then the triangle cost of each sphere topology at equal silhouette error.
+
+namespace {
+// Keeps results observable so the kernels are not optimized away
+volatile size_t g_sink = 0;
+
+struct BenchmarkConfig {
+  std::vector<int> segments;
+  std::vector<int> instanceCounts;
+  int repetitions;
+};
+
+// Median milliseconds of kernel over the repetitions; setup runs untimed before each
+template <typename Setup, typename Kernel>
+double medianMs(int repetitions, const Setup& setup, const Kernel& kernel) {
+  std::vector<double> times;
+  for (int i = 0; i < repetitions; ++i) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    kernel();
+    times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+template <typename Kernel>
+double medianMs(int repetitions, const Kernel& kernel) {
+  return medianMs(repetitions, [] {}, kernel);
+}
+
+void printHeader() {
+  std::cout << std::left << std::setw(28) << "Kernel" << std::right << std::setw(12) << "Items" << std::setw(12) << "Median ms" << std::setw(14) << "M items/s"
+            << std::endl;
+  std::cout << std::string(66, '-') << std::endl;
+}
+
+void printRow(const std::string& kernel, size_t items, double ms) {
+  double throughput = ms > 0.0 ? static_cast<double>(items) / (ms * 1000.0) : 0.0;
+  std::cout << std::left << std::setw(28) << kernel << std::right << std::setw(12) << items << std::setw(12) << std::fixed << std::setprecision(3) << ms
+            << std::setw(14) << std::setprecision(1) << throughput << std::endl;
+}
+
+void benchmarkSphereGeneration(const BenchmarkConfig& config) {
+  for (int segments : config.segments) {
+    size_t vertices = 0;
+    double ms = medianMs(config.repetitions, [&] {
+      SphereGeometry sphere = Sphere::generateSphere(segments);
+      vertices = sphere.vertexCount;
+      g_sink = g_sink + sphere.indexCount;
+    });
+    printRow("generateSphere/" + std::to_string(segments), vertices, ms);
+  }
+}
+
+// Each topology at the silhouette error of the UV sphere with the same segments
+void benchmarkSphereTopologies(const BenchmarkConfig& config) {
+  std::cout << std::endl
+            << std::left << std::setw(28) << "Topology" << std::right << std::setw(12) << "Segments" << std::setw(12) << "Triangles" << std::setw(12) << "Vertices"
+            << std::setw(12) << "Error" << std::setw(12) << "Median ms" << std::endl;
+  std::cout << std::string(88, '-') << std::endl;
+  for (int segments : config.segments) {
+    for (int i = 0; i < SPHERE_TOPOLOGY_COUNT; ++i) {
+      SphereTopology topology = static_cast<SphereTopology>(i);
+      SphereGeometry sphere = Sphere::generate(topology, segments);
+      double ms = medianMs(config.repetitions, [&] {
+        SphereGeometry generated = Sphere::generate(topology, segments);
+        g_sink = g_sink + generated.indexCount;
+      });
+      std::cout << std::left << std::setw(28) << SPHERE_TOPOLOGY_NAMES[i] << std::right << std::setw(12) << segments << std::setw(12) << sphere.indexCount / 3
+                << std::setw(12) << sphere.vertexCount << std::setw(12) << std::setprecision(5) << Sphere::getSilhouetteError(sphere) << std::setw(12)
+                << std::setprecision(3) << ms << std::endl;
+    }
+  }
+}
+
+void benchmarkGrid(const BenchmarkConfig& config) {
+  std::vector<glm::mat4> matrices;
+  for (int count : config.instanceCounts) {
+    double ms = medianMs(config.repetitions, [&] {
+      generateGridMatrices(count, 0.1f, matrices);
+      g_sink = g_sink + matrices.size();
+    });
+    printRow("generateGridMatrices", count, ms);
+  }
+}
+
+void benchmarkCulling(const BenchmarkConfig& config) {
+  // Camera above one corner of the grid, so a part of it is culled
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(-20.0f, 15.0f, -20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::vec4 planes[6];
+  extractFrustumPlanes(projection * view, planes);
+
+  std::vector<glm::mat4> matrices;
+  for (int count : config.instanceCounts) {
+    generateGridMatrices(count, 0.1f, matrices);
+    double ms = medianMs(config.repetitions, [&] {
+      size_t visible = 0;
+      for (const glm::mat4& model : matrices) {
+        float radius = 0.05f * glm::length(glm::vec3(model[0]));
+        visible += sphereInFrustum(planes, model[3], radius) ? 1 : 0;
+      }
+      g_sink = g_sink + visible;
+    });
+    printRow("sphereInFrustum", count, ms);
+
+    // Same test streaming only the bounds column, 16 bytes per instance instead of 64
+    InstanceAttributeStore store;
+    store.resize(count);
+    std::copy(matrices.begin(), matrices.end(), store.getMutable<InstanceAttribute::MATRIX>());
+    store.updateBounds(0, store.size());
+    const glm::vec4* bounds = store.get<InstanceAttribute::BOUNDS>();
+    ms = medianMs(config.repetitions, [&] {
+      size_t visible = 0;
+      for (int i = 0; i < count; ++i) {
+        visible += sphereInFrustum(planes, glm::vec4(glm::vec3(bounds[i]), 1.0f), 0.05f * bounds[i].w) ? 1 : 0;
+      }
+      g_sink = g_sink + visible;
+    });
+    printRow("sphereInFrustum bounds", count, ms);
+  }
+}
+
+void benchmarkRadixSort(const BenchmarkConfig& config, ThreadPool* pool, const std::string& label) {
+  // LOD and sorted depth, the widest key the frame pipeline builds
+  const int keyBits = 18;
+  std::mt19937 random(42);
+  RadixSorter sorter;
+
+  for (int count : config.instanceCounts) {
+    std::vector<uint32_t> inputKeys(count);
+    for (uint32_t& key : inputKeys) {
+      key = random() & ((1u << keyBits) - 1);
+    }
+    std::vector<uint32_t> keys(count);
+    std::vector<uint32_t> values(count);
+    double ms = medianMs(
+        config.repetitions,
+        [&] {
+          std::memcpy(keys.data(), inputKeys.data(), count * sizeof(uint32_t));
+          for (int i = 0; i < count; ++i) {
+            values[i] = static_cast<uint32_t>(i);
+          }
+        },
+        [&] {
+          sorter.sort(keys.data(), values.data(), count, keyBits, pool);
+          g_sink = g_sink + values[0];
+        });
+    printRow(label, count, ms);
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // --quick runs a single small size, enough to check the kernels still work
+  bool quick = argc > 1 && std::string(argv[1]) == "--quick";
+  BenchmarkConfig config;
+  if (quick) {
+    config = {{16}, {1000}, 3};
+  } else {
+    config = {{8, 16, 32, 64, 128}, {1000, 10000, 100000, 1000000}, 11};
+  }
+
+  ThreadPool pool;
+
+  printHeader();
+  benchmarkSphereGeneration(config);
+  benchmarkGrid(config);
+  benchmarkCulling(config);
+  benchmarkRadixSort(config, nullptr, "RadixSorter 1 thread");
+  benchmarkRadixSort(config, &pool, "RadixSorter pool of " + std::to_string(pool.getThreadCount()));
+  benchmarkSphereTopologies(config);
+  return 0;
+}
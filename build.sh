@@ -100,6 +100,11 @@ echo ""
 echo "To run the application:"
 echo "  ./build/OpenGLRenderer"
 echo ""
+echo "To run the CPU unit tests and a short benchmark (no display needed):"
+echo "  ctest --test-dir build --output-on-failure"
+echo "  ./build/CoreBenchmark"
+echo "Without GLFW/GLEW/OpenGL/ImGui, install with 'conan install . -o renderer=False' (BUILD_RENDERER=OFF)"
+echo ""
 echo "To run with debug output:"
 echo "  MESA_DEBUG=silent ./build/OpenGLRenderer"
 echo ""
\ No newline at end of file
@@ -1,6 +1,40 @@
 # CMake Shader Stringification Module
 # Pure CMake solution to convert shader files to C++ header files
 
+# Optional offline tools: glslangValidator checks every shader at build time and compiles the
+# sphere variants to SPIR-V, spirv-opt shrinks those modules. Without them GLSL is compiled at runtime.
+find_program(GLSLANG_VALIDATOR glslangValidator)
+find_program(SPIRV_OPT spirv-opt)
+if(GLSLANG_VALIDATOR)
+    message(STATUS "Validating shaders and embedding SPIR-V with ${GLSLANG_VALIDATOR}")
+else()
+    message(STATUS "glslangValidator not found, shaders are embedded as GLSL only")
+endif()
+
+# Sphere variants precompiled to SPIR-V (generated/shaders/sphere_spirv.h, an empty table without
+# glslangValidator) behind the custom target TARGET_NAME. Needs no GL, the unit tests check the table too.
+function(add_sphere_spirv_header TARGET_NAME)
+    set(SHADER_DIR "${CMAKE_SOURCE_DIR}/src/shaders")
+    set(SPIRV_HEADER "${CMAKE_BINARY_DIR}/generated/shaders/sphere_spirv.h")
+    add_custom_command(
+        OUTPUT "${SPIRV_HEADER}"
+        COMMAND ${CMAKE_COMMAND}
+            -DSHADER_DIR="${SHADER_DIR}"
+            -DOUTPUT_HEADER="${SPIRV_HEADER}"
+            -DGLSLANG_VALIDATOR="${GLSLANG_VALIDATOR}"
+            -DSPIRV_OPT="${SPIRV_OPT}"
+            -P "${CMAKE_SOURCE_DIR}/cmake/sphere_spirv.cmake"
+        DEPENDS
+            "${SHADER_DIR}/sphere.vert"
+            "${SHADER_DIR}/pulling.vert"
+            "${SHADER_DIR}/sphere.frag"
+            "${CMAKE_SOURCE_DIR}/cmake/sphere_spirv.cmake"
+        COMMENT "Compiling sphere shader variants to SPIR-V"
+        VERBATIM
+    )
+    add_custom_target(${TARGET_NAME} DEPENDS "${SPIRV_HEADER}")
+endfunction()
+
 # Function to add shader headers to a target
 function(add_shader_headers TARGET_NAME)
     set(SHADER_DIR "${CMAKE_SOURCE_DIR}/src/shaders")
@@ -50,6 +84,7 @@ function(add_shader_headers TARGET_NAME)
             COMMAND ${CMAKE_COMMAND} 
                 -DSHADER_FILE="${SHADER_FILE}"
                 -DOUTPUT_HEADER="${OUTPUT_HEADER}"
+                -DGLSLANG_VALIDATOR="${GLSLANG_VALIDATOR}"
                 -P "${CMAKE_SOURCE_DIR}/cmake/stringify_single_shader.cmake"
             DEPENDS "${SHADER_FILE}"
             COMMENT "Generating header for ${SHADER_FILE}"
@@ -58,7 +93,7 @@ function(add_shader_headers TARGET_NAME)
         
         list(APPEND GENERATED_HEADERS "${OUTPUT_HEADER}")
     endforeach()
-    
+
     # Create a custom target for all generated headers
     add_custom_target(${TARGET_NAME}_shaders
         DEPENDS ${GENERATED_HEADERS}
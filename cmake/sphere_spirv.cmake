@@ -0,0 +1,135 @@
+# CMake script compiling the sphere shader variants to SPIR-V and embedding them as word arrays
+# This script is called by the add_shader_headers function. Without glslangValidator the header
+# holds an empty table and every variant is compiled from GLSL at runtime.
+
+if(NOT DEFINED SHADER_DIR)
+    message(FATAL_ERROR "SHADER_DIR must be defined")
+endif()
+
+if(NOT DEFINED OUTPUT_HEADER)
+    message(FATAL_ERROR "OUTPUT_HEADER must be defined")
+endif()
+
+# Remove any extra quotes that might be present in paths
+string(REGEX REPLACE "^\"(.*)\"$" "\\1" SHADER_DIR "${SHADER_DIR}")
+string(REGEX REPLACE "^\"(.*)\"$" "\\1" OUTPUT_HEADER "${OUTPUT_HEADER}")
+string(REGEX REPLACE "^\"(.*)\"$" "\\1" GLSLANG_VALIDATOR "${GLSLANG_VALIDATOR}")
+string(REGEX REPLACE "^\"(.*)\"$" "\\1" SPIRV_OPT "${SPIRV_OPT}")
+
+get_filename_component(OUTPUT_DIR "${OUTPUT_HEADER}" DIRECTORY)
+set(SPIRV_DIR "${OUTPUT_DIR}/spirv")
+file(MAKE_DIRECTORY "${SPIRV_DIR}")
+
+set(MODULE_COUNT 0)
+set(MODULE_DEFINITIONS "")
+set(VARIANT_ENTRIES "")
+set(VARIANT_COUNT 0)
+
+# Compiles SOURCE with the space-separated DEFINES into MODULE_NAME and MODULE_WORDS.
+# Identical modules are embedded once; after spirv-opt the fragment shader only differs by DRAW_ID.
+macro(embed_spirv_module SOURCE DEFINES)
+    set(DEFINE_ARGS "")
+    string(REPLACE " " ";" DEFINE_LIST "${DEFINES}")
+    foreach(DEFINE IN LISTS DEFINE_LIST)
+        list(APPEND DEFINE_ARGS "-D${DEFINE}")
+    endforeach()
+
+    set(SPIRV_FILE "${SPIRV_DIR}/module_${MODULE_COUNT}.spv")
+    execute_process(
+        COMMAND "${GLSLANG_VALIDATOR}" -G ${DEFINE_ARGS} -o "${SPIRV_FILE}" "${SOURCE}"
+        RESULT_VARIABLE COMPILE_RESULT
+        OUTPUT_VARIABLE COMPILE_OUTPUT
+        ERROR_VARIABLE COMPILE_OUTPUT
+    )
+    if(NOT COMPILE_RESULT EQUAL 0)
+        message(FATAL_ERROR "SPIR-V compilation failed for ${SOURCE} with '${DEFINES}':\n${COMPILE_OUTPUT}")
+    endif()
+
+    # Debug info goes too, locations are explicit and names are never queried
+    if(SPIRV_OPT)
+        execute_process(
+            COMMAND "${SPIRV_OPT}" -O --strip-debug "${SPIRV_FILE}" -o "${SPIRV_FILE}"
+            RESULT_VARIABLE OPTIMIZE_RESULT
+            OUTPUT_VARIABLE OPTIMIZE_OUTPUT
+            ERROR_VARIABLE OPTIMIZE_OUTPUT
+        )
+        if(NOT OPTIMIZE_RESULT EQUAL 0)
+            message(FATAL_ERROR "spirv-opt failed for ${SOURCE} with '${DEFINES}':\n${OPTIMIZE_OUTPUT}")
+        endif()
+    endif()
+
+    file(SHA256 "${SPIRV_FILE}" MODULE_HASH)
+    if(DEFINED MODULE_${MODULE_HASH})
+        set(MODULE_NAME "${MODULE_${MODULE_HASH}}")
+        set(MODULE_WORDS "${MODULE_WORDS_${MODULE_HASH}}")
+    else()
+        set(MODULE_NAME "SPHERE_SPIRV_${MODULE_COUNT}")
+        math(EXPR MODULE_COUNT "${MODULE_COUNT} + 1")
+
+        # SPIR-V is a stream of little-endian words
+        file(READ "${SPIRV_FILE}" MODULE_HEX HEX)
+        string(LENGTH "${MODULE_HEX}" MODULE_HEX_LENGTH)
+        math(EXPR MODULE_WORDS "${MODULE_HEX_LENGTH} / 8")
+        string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u, " MODULE_ARRAY "${MODULE_HEX}")
+        string(REGEX REPLACE "((0x[0-9a-f]+u, ){8})" "\\1\n    " MODULE_ARRAY "${MODULE_ARRAY}")
+        string(REPLACE ", \n" ",\n" MODULE_ARRAY "${MODULE_ARRAY}")
+        string(STRIP "${MODULE_ARRAY}" MODULE_ARRAY)
+        string(APPEND MODULE_DEFINITIONS "constexpr uint32_t ${MODULE_NAME}[] = {\n    ${MODULE_ARRAY}\n};\n\n")
+
+        set(MODULE_${MODULE_HASH} "${MODULE_NAME}")
+        set(MODULE_WORDS_${MODULE_HASH} "${MODULE_WORDS}")
+    endif()
+endmacro()
+
+macro(embed_spirv_variant VERTEX_SOURCE DEFINES)
+    embed_spirv_module("${VERTEX_SOURCE}" "${DEFINES}")
+    set(VERTEX_NAME "${MODULE_NAME}")
+    set(VERTEX_WORDS "${MODULE_WORDS}")
+    embed_spirv_module("${SHADER_DIR}/sphere.frag" "${DEFINES}")
+    string(APPEND VARIANT_ENTRIES "    {\"${DEFINES}\", ${VERTEX_NAME}, ${VERTEX_WORDS}, ${MODULE_NAME}, ${MODULE_WORDS}},\n")
+    math(EXPR VARIANT_COUNT "${VARIANT_COUNT} + 1")
+endmacro()
+
+if(GLSLANG_VALIDATOR)
+    # Every define set sphereShaderVariant produces, in SHADER_FEATURE_DEFINES order; CoreTests fails when they differ
+    foreach(FORMAT_DEFINES IN ITEMS "" "VERTEX_FORMAT_SNORM16 " "VERTEX_FORMAT_OCTAHEDRAL ")
+        foreach(INSTANCE_DEFINES IN ITEMS "" "DRAW_ID " "INSTANCE_ATTRIBUTE " "INSTANCE_TEXELS " "DRAW_ID INSTANCE_TEXELS ")
+            string(STRIP "${FORMAT_DEFINES}${INSTANCE_DEFINES}" VARIANT_DEFINES)
+            embed_spirv_variant("${SHADER_DIR}/sphere.vert" "${VARIANT_DEFINES}")
+        endforeach()
+    endforeach()
+    embed_spirv_variant("${SHADER_DIR}/pulling.vert" "VERTEX_PULLING")
+else()
+    # A null entry keeps the array non-empty, callers skip it
+    set(VARIANT_ENTRIES "    {\"\", nullptr, 0, nullptr, 0},\n")
+endif()
+
+set(HEADER_CONTENT
+"#pragma once
+
+// Auto-generated from sphere.vert, pulling.vert and sphere.frag
+// Do not edit this file directly!
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GeneratedShaders {
+
+// SPIR-V of one sphere variant, named by its ShaderFeature defines in SHADER_FEATURE_DEFINES order
+struct SphereSpirvVariant {
+  const char* defines;
+  const uint32_t* vertex;
+  size_t vertexWords;
+  const uint32_t* fragment;
+  size_t fragmentWords;
+};
+
+${MODULE_DEFINITIONS}constexpr SphereSpirvVariant SPHERE_SPIRV_VARIANTS[] = {
+${VARIANT_ENTRIES}};
+
+} // namespace GeneratedShaders
+")
+
+file(WRITE "${OUTPUT_HEADER}" "${HEADER_CONTENT}")
+
+message(STATUS "Generated SPIR-V header with ${VARIANT_COUNT} variants: ${OUTPUT_HEADER}")
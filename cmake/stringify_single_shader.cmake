@@ -13,12 +13,26 @@ endif()
 # Remove any extra quotes that might be present in paths
 string(REGEX REPLACE "^\"(.*)\"$" "\\1" SHADER_FILE "${SHADER_FILE}")
 string(REGEX REPLACE "^\"(.*)\"$" "\\1" OUTPUT_HEADER "${OUTPUT_HEADER}")
+string(REGEX REPLACE "^\"(.*)\"$" "\\1" GLSLANG_VALIDATOR "${GLSLANG_VALIDATOR}")
 
 # Check if shader file exists
 if(NOT EXISTS "${SHADER_FILE}")
     message(FATAL_ERROR "Shader file does not exist: ${SHADER_FILE}")
 endif()
 
+# Validate with the reference compiler when available, so GLSL errors fail the build rather than the first run
+if(GLSLANG_VALIDATOR)
+    execute_process(
+        COMMAND "${GLSLANG_VALIDATOR}" "${SHADER_FILE}"
+        RESULT_VARIABLE VALIDATION_RESULT
+        OUTPUT_VARIABLE VALIDATION_OUTPUT
+        ERROR_VARIABLE VALIDATION_OUTPUT
+    )
+    if(NOT VALIDATION_RESULT EQUAL 0)
+        message(FATAL_ERROR "Shader validation failed for ${SHADER_FILE}:\n${VALIDATION_OUTPUT}")
+    endif()
+endif()
+
 # Get the shader filename without path and extension for variable naming
 get_filename_component(SHADER_NAME "${SHADER_FILE}" NAME_WE)
 get_filename_component(SHADER_EXT "${SHADER_FILE}" EXT)
@@ -57,18 +71,17 @@ get_filename_component(OUTPUT_DIR "${OUTPUT_HEADER}" DIRECTORY)
 file(MAKE_DIRECTORY "${OUTPUT_DIR}")
 
 # Create the header content
-# Note: We use a different delimiter to avoid conflicts with shader content
+# Note: We use a different delimiter to avoid conflicts with shader content.
+# A constexpr array lives in read-only data, a std::string would be copied at static init in every includer.
 set(HEADER_CONTENT 
 "#pragma once
 
 // Auto-generated from ${SHADER_FILENAME}
 // Do not edit this file directly!
 
-#include <string>
-
 namespace GeneratedShaders {
 
-const std::string ${VARIABLE_NAME} = R\"SHADER_DELIMITER(${SHADER_CONTENT})SHADER_DELIMITER\";
+constexpr char ${VARIABLE_NAME}[] = R\"SHADER_DELIMITER(${SHADER_CONTENT})SHADER_DELIMITER\";
 
 } // namespace GeneratedShaders
 ")
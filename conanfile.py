@@ -6,21 +6,33 @@ import os
 
 class OpenGLRendererConan(ConanFile):
     settings = "os", "compiler", "build_type", "arch"
-    generators = "CMakeDeps", "CMakeToolchain"
+    # renderer=False installs only what the CPU tests and benchmarks need (BUILD_RENDERER=OFF)
+    options = {"renderer": [True, False]}
+    default_options = {"renderer": True}
+    generators = "CMakeDeps"
 
     def requirements(self):
-        self.requires("glfw/3.3.8")
-        self.requires("glew/2.2.0")
         self.requires("glm/0.9.9.8")
-        self.requires("opengl/system")
-        self.requires("imgui/1.89.9")
+        if self.options.renderer:
+            self.requires("glfw/3.3.8")
+            self.requires("glew/2.2.0")
+            self.requires("opengl/system")
+            self.requires("imgui/1.89.9")
 
     def configure(self):
-        self.options["glfw"].shared = False
-        self.options["glew"].shared = False
-        self.options["imgui"].shared = False
+        if self.options.renderer:
+            self.options["glfw"].shared = False
+            self.options["glew"].shared = False
+            self.options["imgui"].shared = False
 
     def generate(self):
+        toolchain = CMakeToolchain(self)
+        toolchain.variables["BUILD_RENDERER"] = bool(self.options.renderer)
+        toolchain.generate()
+
+        if not self.options.renderer:
+            return
+
         info = self.dependencies["imgui"].cpp_info.srcdirs
         # copy to the build folder the imgui backends
         copy(
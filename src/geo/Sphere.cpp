@@ -1,66 +1,120 @@
 #include "Sphere.h"
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace
+{
+// Golden ratio, the icosahedron's corners are the cyclic permutations of (0, +-1, +-T)
+const float T = 1.61803398874989484820f;
+
+const float ICOSAHEDRON_CORNERS[][3] = {
+    {-1.0f, T, 0.0f}, {1.0f, T, 0.0f}, {-1.0f, -T, 0.0f}, {1.0f, -T, 0.0f},
+    {0.0f, -1.0f, T}, {0.0f, 1.0f, T}, {0.0f, -1.0f, -T}, {0.0f, 1.0f, -T},
+    {T, 0.0f, -1.0f}, {T, 0.0f, 1.0f}, {-T, 0.0f, -1.0f}, {-T, 0.0f, 1.0f},
+};
+
+const unsigned int ICOSAHEDRON_FACES[][3] = {
+    {0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10}, {0, 10, 11}, {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+    {3, 9, 4},  {3, 4, 2},  {3, 2, 6},   {3, 6, 8},  {3, 8, 9},   {4, 9, 5}, {2, 4, 11}, {6, 2, 10},  {8, 6, 7},  {9, 8, 1},
+};
+
+const float OCTAHEDRON_CORNERS[][3] = {
+    {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f},
+};
+
+const unsigned int OCTAHEDRON_FACES[][3] = {
+    {4, 0, 2}, {0, 5, 2}, {5, 1, 2}, {1, 4, 2}, {0, 4, 3}, {5, 0, 3}, {1, 5, 3}, {4, 1, 3},
+};
+
+// Subdivision frequency per UV sector step at about equal silhouette error, where generate() starts searching
+const float ICOSPHERE_FREQUENCY_PER_SECTOR = 0.176f;
+const float OCTASPHERE_FREQUENCY_PER_SECTOR = 0.325f;
+
+// Run of frequency - 1 vertices inside an edge, from its lower to its higher corner
+struct PolyhedronEdge
+{
+    unsigned int low;
+    unsigned int high;
+    unsigned int firstVertex;
+};
+}  // namespace
+
 SphereGeometry Sphere::generateSphere(int segments, float radius)
 {
     SphereGeometry geometry;
 
-    // Clear vectors
-    geometry.vertices.clear();
-    geometry.indices.clear();
-
-    // Calculate number of vertices and indices
     int rings = segments;
     int sectors = segments * 2;
 
     float const R = 1.0f / (float)(rings - 1);
     float const S = 1.0f / (float)(sectors - 1);
 
+    // One sin/cos pair per ring and per sector instead of four calls per vertex
+    std::vector<float> ringY(rings);
+    std::vector<float> ringRadius(rings);
+    for (int r = 0; r < rings; ++r)
+    {
+        ringY[r] = (float)sin(-M_PI / 2 + M_PI * r * R);
+        ringRadius[r] = (float)sin(M_PI * r * R);
+    }
+
+    std::vector<float> sectorCos(sectors);
+    std::vector<float> sectorSin(sectors);
+    for (int s = 0; s < sectors; ++s)
+    {
+        sectorCos[s] = (float)cos(2 * M_PI * s * S);
+        sectorSin[s] = (float)sin(2 * M_PI * s * S);
+    }
+
     // Generate vertices
+    geometry.vertices.resize(rings * sectors);
+    Vertex* vertex = geometry.vertices.data();
     for (int r = 0; r < rings; ++r)
     {
         for (int s = 0; s < sectors; ++s)
         {
-            float const y = sin(-M_PI / 2 + M_PI * r * R);
-            float const x = cos(2 * M_PI * s * S) * sin(M_PI * r * R);
-            float const z = sin(2 * M_PI * s * S) * sin(M_PI * r * R);
+            float const y = ringY[r];
+            float const x = sectorCos[s] * ringRadius[r];
+            float const z = sectorSin[s] * ringRadius[r];
 
-            Vertex vertex;
             // Position
-            vertex.x = x * radius;
-            vertex.y = y * radius;
-            vertex.z = z * radius;
+            vertex->x = x * radius;
+            vertex->y = y * radius;
+            vertex->z = z * radius;
 
             // Normal (normalized position for a unit sphere)
-            vertex.nx = x;
-            vertex.ny = y;
-            vertex.nz = z;
+            vertex->nx = x;
+            vertex->ny = y;
+            vertex->nz = z;
 
-            geometry.vertices.push_back(vertex);
+            vertex++;
         }
     }
 
     // Generate indices
+    geometry.indices.resize((rings - 1) * (sectors - 1) * 6);
+    unsigned int* index = geometry.indices.data();
     for (int r = 0; r < rings - 1; ++r)
     {
+        int curRow = r * sectors;
+        int nextRow = (r + 1) * sectors;
+
         for (int s = 0; s < sectors - 1; ++s)
         {
-            int curRow = r * sectors;
-            int nextRow = (r + 1) * sectors;
-
             // First triangle
-            geometry.indices.push_back(curRow + s);
-            geometry.indices.push_back(nextRow + s);
-            geometry.indices.push_back(nextRow + (s + 1));
+            *index++ = curRow + s;
+            *index++ = nextRow + s;
+            *index++ = nextRow + (s + 1);
 
             // Second triangle
-            geometry.indices.push_back(curRow + s);
-            geometry.indices.push_back(nextRow + (s + 1));
-            geometry.indices.push_back(curRow + (s + 1));
+            *index++ = curRow + s;
+            *index++ = nextRow + (s + 1);
+            *index++ = curRow + (s + 1);
         }
     }
 
@@ -70,17 +124,208 @@ SphereGeometry Sphere::generateSphere(int segments, float radius)
     return geometry;
 }
 
-void Sphere::_addVertex(std::vector<Vertex>& vertices, float x, float y, float z, float radius)
+SphereGeometry Sphere::generateIcosphere(int frequency, float radius)
 {
-    Vertex vertex;
-    vertex.x = x * radius;
-    vertex.y = y * radius;
-    vertex.z = z * radius;
-
-    // Normal is the normalized position for a unit sphere
-    vertex.nx = x;
-    vertex.ny = y;
-    vertex.nz = z;
-
-    vertices.push_back(vertex);
-}
\ No newline at end of file
+    return _generatePolyhedron(ICOSAHEDRON_CORNERS, 12, ICOSAHEDRON_FACES, 20, frequency, radius);
+}
+
+SphereGeometry Sphere::generateOctasphere(int frequency, float radius)
+{
+    return _generatePolyhedron(OCTAHEDRON_CORNERS, 6, OCTAHEDRON_FACES, 8, frequency, radius);
+}
+
+SphereGeometry Sphere::generate(SphereTopology topology, int segments, float radius)
+{
+    if (topology == SphereTopology::UV)
+    {
+        return generateSphere(segments, radius);
+    }
+
+    // Both errors shrink with the square of the edge length, so the frequency matching the UV sphere
+    // grows about linearly with its sectors; walk from that estimate to the lowest one meeting the error
+    float targetError = getSilhouetteError(generateSphere(segments));
+    bool icosphere = topology == SphereTopology::ICOSPHERE;
+    auto generateAt = [&](int frequency) { return icosphere ? generateIcosphere(frequency, radius) : generateOctasphere(frequency, radius); };
+
+    float frequencyPerSector = icosphere ? ICOSPHERE_FREQUENCY_PER_SECTOR : OCTASPHERE_FREQUENCY_PER_SECTOR;
+    int frequency = std::max(1, (int)(frequencyPerSector * (2 * segments - 1)));
+    SphereGeometry geometry = generateAt(frequency);
+    while (getSilhouetteError(geometry, radius) > targetError)
+    {
+        geometry = generateAt(++frequency);
+    }
+    while (frequency > 1)
+    {
+        SphereGeometry coarser = generateAt(frequency - 1);
+        if (getSilhouetteError(coarser, radius) > targetError)
+        {
+            break;
+        }
+        geometry = std::move(coarser);
+        frequency--;
+    }
+    return geometry;
+}
+
+float Sphere::getSilhouetteError(const SphereGeometry& geometry, float radius)
+{
+    // A triangle dips deepest where its plane is closest to the center
+    double maxError = 0.0;
+    for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3)
+    {
+        const Vertex& a = geometry.vertices[geometry.indices[i]];
+        const Vertex& b = geometry.vertices[geometry.indices[i + 1]];
+        const Vertex& c = geometry.vertices[geometry.indices[i + 2]];
+
+        double abX = b.x - a.x, abY = b.y - a.y, abZ = b.z - a.z;
+        double acX = c.x - a.x, acY = c.y - a.y, acZ = c.z - a.z;
+        double nX = abY * acZ - abZ * acY;
+        double nY = abZ * acX - abX * acZ;
+        double nZ = abX * acY - abY * acX;
+        double length = sqrt(nX * nX + nY * nY + nZ * nZ);
+
+        // UV pole triangles collapse to lines
+        if (length <= 1e-12 * radius * radius)
+        {
+            continue;
+        }
+
+        double distance = fabs(nX * a.x + nY * a.y + nZ * a.z) / length;
+        maxError = std::max(maxError, 1.0 - distance / radius);
+    }
+    return (float)maxError;
+}
+
+SphereGeometry Sphere::_generatePolyhedron(const float (*corners)[3], int cornerCount, const unsigned int (*faces)[3], int faceCount, int frequency,
+                                           float radius)
+{
+    SphereGeometry geometry;
+
+    int f = std::max(1, frequency);
+
+    // Corners first, then the vertices inside each edge, then those inside each face
+    int edgeCount = faceCount * 3 / 2;
+    geometry.vertices.resize(cornerCount + edgeCount * (f - 1) + faceCount * (f - 1) * (f - 2) / 2);
+    geometry.indices.resize(faceCount * f * f * 3);
+
+    Vertex* vertices = geometry.vertices.data();
+    for (int c = 0; c < cornerCount; ++c)
+    {
+        _setVertex(vertices[c], corners[c][0], corners[c][1], corners[c][2], radius);
+    }
+    unsigned int nextVertex = cornerCount;
+
+    // Vertex step of the way from corner u to corner v, the edge's run is created by the first face using it
+    std::vector<PolyhedronEdge> edges;
+    edges.reserve(edgeCount);
+    auto edgeVertex = [&](unsigned int u, unsigned int v, int step) -> unsigned int
+    {
+        unsigned int low = std::min(u, v);
+        unsigned int high = std::max(u, v);
+        auto edge = std::find_if(edges.begin(), edges.end(), [&](const PolyhedronEdge& e) { return e.low == low && e.high == high; });
+        if (edge == edges.end())
+        {
+            edges.push_back({low, high, nextVertex});
+            edge = edges.end() - 1;
+            for (int s = 1; s < f; ++s)
+            {
+                float x = corners[low][0] * (f - s) + corners[high][0] * s;
+                float y = corners[low][1] * (f - s) + corners[high][1] * s;
+                float z = corners[low][2] * (f - s) + corners[high][2] * s;
+                _setVertex(vertices[nextVertex++], x, y, z, radius);
+            }
+        }
+        int stepFromLow = u == low ? step : f - step;
+        return edge->firstVertex + stepFromLow - 1;
+    };
+
+    // Vertex of grid point (i, j) in the current face, which weighs the face corners by f - i - j, i and j
+    std::vector<unsigned int> grid((f + 1) * (f + 1));
+    unsigned int* index = geometry.indices.data();
+
+    for (int face = 0; face < faceCount; ++face)
+    {
+        const unsigned int* corner = faces[face];
+        const float* a = corners[corner[0]];
+        const float* b = corners[corner[1]];
+        const float* c = corners[corner[2]];
+
+        for (int i = 0; i <= f; ++i)
+        {
+            for (int j = 0; i + j <= f; ++j)
+            {
+                int k = f - i - j;
+                unsigned int& vertex = grid[i * (f + 1) + j];
+                if (k == f)
+                {
+                    vertex = corner[0];
+                }
+                else if (i == f)
+                {
+                    vertex = corner[1];
+                }
+                else if (j == f)
+                {
+                    vertex = corner[2];
+                }
+                else if (j == 0)
+                {
+                    vertex = edgeVertex(corner[0], corner[1], i);
+                }
+                else if (i == 0)
+                {
+                    vertex = edgeVertex(corner[0], corner[2], j);
+                }
+                else if (k == 0)
+                {
+                    vertex = edgeVertex(corner[1], corner[2], j);
+                }
+                else
+                {
+                    vertex = nextVertex++;
+                    _setVertex(vertices[vertex], a[0] * k + b[0] * i + c[0] * j, a[1] * k + b[1] * i + c[1] * j, a[2] * k + b[2] * i + c[2] * j, radius);
+                }
+            }
+        }
+
+        // Two triangles per grid cell, one in the cells along the far edge, wound like the face
+        for (int i = 0; i < f; ++i)
+        {
+            for (int j = 0; i + j < f; ++j)
+            {
+                unsigned int current = grid[i * (f + 1) + j];
+                unsigned int nextI = grid[(i + 1) * (f + 1) + j];
+                unsigned int nextJ = grid[i * (f + 1) + j + 1];
+
+                *index++ = current;
+                *index++ = nextI;
+                *index++ = nextJ;
+
+                if (i + j < f - 1)
+                {
+                    *index++ = nextI;
+                    *index++ = grid[(i + 1) * (f + 1) + j + 1];
+                    *index++ = nextJ;
+                }
+            }
+        }
+    }
+
+    geometry.vertexCount = geometry.vertices.size();
+    geometry.indexCount = geometry.indices.size();
+
+    return geometry;
+}
+
+void Sphere::_setVertex(Vertex& vertex, float x, float y, float z, float radius)
+{
+    // Normal is the direction from the center, the position lies on the sphere along it
+    float length = sqrtf(x * x + y * y + z * z);
+    vertex.nx = x / length;
+    vertex.ny = y / length;
+    vertex.nz = z / length;
+
+    vertex.x = vertex.nx * radius;
+    vertex.y = vertex.ny * radius;
+    vertex.z = vertex.nz * radius;
+}
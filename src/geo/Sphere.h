@@ -17,13 +17,39 @@ struct SphereGeometry
     unsigned int indexCount;
 };
 
+// How the sphere surface is split into triangles
+enum class SphereTopology
+{
+    UV = 0,         // Rings and sectors, triangles crowd at the poles
+    ICOSPHERE = 1,  // Subdivided icosahedron, nearly uniform triangles
+    OCTASPHERE = 2  // Subdivided octahedron, seams along the axes
+};
+
+const char* const SPHERE_TOPOLOGY_NAMES[] = {"UV Sphere", "Icosphere", "Octasphere"};
+
+const int SPHERE_TOPOLOGY_COUNT = sizeof(SPHERE_TOPOLOGY_NAMES) / sizeof(SPHERE_TOPOLOGY_NAMES[0]);
+
 class Sphere
 {
 public:
+    // UV sphere with segments rings and 2 * segments sectors, the seam column duplicated
     static SphereGeometry generateSphere(int segments, float radius = 1.0f);
 
+    // Every face of the solid split into frequency^2 triangles and projected onto the sphere.
+    // Vertices on face edges are shared, so the mesh is closed.
+    static SphereGeometry generateIcosphere(int frequency, float radius = 1.0f);
+    static SphereGeometry generateOctasphere(int frequency, float radius = 1.0f);
+
+    // Topology at the lowest frequency whose silhouette error is no worse than the UV sphere with segments
+    static SphereGeometry generate(SphereTopology topology, int segments, float radius = 1.0f);
+
+    // Deepest point of any triangle below the surface, relative to the radius
+    static float getSilhouetteError(const SphereGeometry& geometry, float radius = 1.0f);
+
 private:
-    static void _addVertex(std::vector<Vertex>& vertices, float x, float y, float z, float radius);
+    static SphereGeometry _generatePolyhedron(const float (*corners)[3], int cornerCount, const unsigned int (*faces)[3], int faceCount, int frequency,
+                                              float radius);
+    static void _setVertex(Vertex& vertex, float x, float y, float z, float radius);
 };
 
-#endif  // SPHERE_H
\ No newline at end of file
+#endif  // SPHERE_H
@@ -1,10 +1,18 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "renderer/BenchmarkRunner.h"
 #include "renderer/Renderer.h"
+#include "utils/Profiler.h"
 
 // Global variables for window resize handling
 static int g_windowWidth = 800;
@@ -19,24 +27,125 @@ static void window_resize_callback(GLFWwindow* window, int width, int height) {
   g_windowWidth = width;
   g_windowHeight = height;
 
-  // Update viewport
-  glViewport(0, 0, width, height);
-
   // Debug output
   std::cout << "Window resized to: " << width << "x" << height << std::endl;
 
-  // Update renderer with new dimensions
+  // Update renderer with new dimensions (also sets the viewport)
   if (g_renderer) {
     g_renderer->onWindowResize(width, height);
   }
 }
 
-int main() {
+static void print_usage(const char* program) {
+  std::cout << "Usage: " << program << " [--benchmark] [--frames N] [--trace FILE] [--no-pipelining] [--render-thread] [--render-scale S]"
+            << " [--camera-path FILE] [--record-path FILE] [--headless] [--scene FILE] [--shadows]"
+            << " [--sphere-topology uv|ico|octa]" << std::endl;
+  std::cout << "  --benchmark   Render every method for a fixed number of frames and print a report" << std::endl;
+  std::cout << "  --frames N    Measured frames per method in benchmark mode (default 300)" << std::endl;
+  std::cout << "  --trace FILE  Write a Chrome trace of CPU zones on exit (requires ENABLE_PROFILER)" << std::endl;
+  std::cout << "  --no-pipelining  Prepare each frame on the main thread instead of overlapping it with the swap" << std::endl;
+  std::cout << "  --render-thread  Submit GL on a dedicated thread, keeping events, input and UI on the main thread" << std::endl;
+  std::cout << "  --render-scale S  Render the scene at S x window resolution and upscale (" << MIN_USER_RENDER_SCALE << " to 1, default 1)" << std::endl;
+  std::cout << "  --camera-path FILE  Fly the camera along a recorded path, one fixed timestep per frame" << std::endl;
+  std::cout << "  --record-path FILE  Record the camera while flying it with the mouse, written on exit" << std::endl;
+  std::cout << "  --headless    Benchmark in a hidden window, implies --benchmark" << std::endl;
+  std::cout << "  --shadows     Render cascaded shadow maps, timed separately in the benchmark" << std::endl;
+  std::cout << "  --sphere-topology T  Triangulate spheres as uv, ico or octa spheres at the same silhouette error" << std::endl;
+  std::cout << "  --scene FILE  Load a scene snapshot saved from the UI: instances, sphere, settings and camera" << std::endl;
+}
+
+// Whole-string finite float argument within [minValue, maxValue]
+static bool parse_float(const char* text, float minValue, float maxValue, float& value) {
+  char* end = nullptr;
+  errno = 0;
+  float parsed = std::strtof(text, &end);
+  if (end == text || *end != '\0' || errno == ERANGE || !(parsed >= minValue && parsed <= maxValue)) {
+    return false;
+  }
+  value = parsed;
+  return true;
+}
+
+// Whole-string integer argument within [minValue, maxValue]
+static bool parse_int(const char* text, int minValue, int maxValue, int& value) {
+  char* end = nullptr;
+  errno = 0;
+  long parsed = std::strtol(text, &end, 10);
+  if (end == text || *end != '\0' || errno == ERANGE || parsed < minValue || parsed > maxValue) {
+    return false;
+  }
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  // Parse command line
+  bool benchmarkMode = false;
+  int benchmarkFrames = 300;
+  std::string tracePath;
+  bool pipelining = true;
+  bool renderThread = false;
+  float renderScale = 1.0f;
+  std::string cameraPath;
+  std::string recordPath;
+  bool headless = false;
+  std::string scenePath;
+  bool shadows = false;
+  int sphereTopology = -1;  // Keep the default, or the scene's
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--benchmark") {
+      benchmarkMode = true;
+    } else if (arg == "--frames" && i + 1 < argc) {
+      if (!parse_int(argv[++i], 1, INT_MAX, benchmarkFrames)) {
+        print_usage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--trace" && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (arg == "--no-pipelining") {
+      pipelining = false;
+    } else if (arg == "--render-thread") {
+      renderThread = true;
+    } else if (arg == "--render-scale" && i + 1 < argc) {
+      if (!parse_float(argv[++i], MIN_USER_RENDER_SCALE, 1.0f, renderScale)) {
+        print_usage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--camera-path" && i + 1 < argc) {
+      cameraPath = argv[++i];
+    } else if (arg == "--record-path" && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (arg == "--scene" && i + 1 < argc) {
+      scenePath = argv[++i];
+    } else if (arg == "--shadows") {
+      shadows = true;
+    } else if (arg == "--sphere-topology" && i + 1 < argc) {
+      std::string name = argv[++i];
+      sphereTopology = name == "uv" ? 0 : name == "ico" ? 1 : name == "octa" ? 2 : -1;
+      if (sphereTopology < 0) {
+        print_usage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--headless") {
+      headless = true;
+      benchmarkMode = true;
+    } else {
+      print_usage(argv[0]);
+      return arg == "--help" ? 0 : -1;
+    }
+  }
+
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+  // Headless runs still need a context, the window is simply never shown
+  if (headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  }
+
   glfwSetErrorCallback(glfw_error_callback);
 
   // Initialize GLFW
@@ -57,8 +166,8 @@ int main() {
   // Make the window's context current
   glfwMakeContextCurrent(window);
 
-  // Enable V-Sync to prevent tearing
-  glfwSwapInterval(1);
+  // Enable V-Sync to prevent tearing (off when benchmarking so frame times are not capped)
+  glfwSwapInterval(benchmarkMode ? 0 : 1);
 
   // Initialize GLEW
   glewExperimental = GL_TRUE;
@@ -81,10 +190,44 @@ int main() {
     std::cerr << "Failed to initialize the renderer" << std::endl;
     return -1;
   }
+  renderer.setPipelinedFrames(pipelining);
+  renderer.setRenderScale(renderScale);
+  if (!scenePath.empty() && !renderer.loadScene(scenePath)) {
+    return -1;
+  }
+  renderer.setShadowsEnabled(shadows);
+  if (sphereTopology >= 0) {
+    renderer.setSphereTopology(static_cast<SphereTopology>(sphereTopology));
+  }
+  if (!cameraPath.empty() && !renderer.loadCameraPath(cameraPath)) {
+    return -1;
+  }
+  if (!recordPath.empty()) {
+    if (!cameraPath.empty()) {
+      std::cerr << "--record-path ignored while playing a camera path" << std::endl;
+    } else {
+      renderer.startCameraRecording(recordPath);
+    }
+  }
 
   // Set window resize callback
   glfwSetFramebufferSizeCallback(window, window_resize_callback);
 
+  // Benchmark runner, cycles through all render methods
+  BenchmarkRunner benchmark(benchmarkFrames);
+  if (benchmarkMode) {
+    benchmark.start(renderer);
+  }
+
+  // The benchmark drives the renderer from this thread, so it keeps the single-threaded loop
+  if (renderThread && benchmarkMode) {
+    std::cerr << "--render-thread ignored in benchmark mode" << std::endl;
+    renderThread = false;
+  }
+  if (renderThread) {
+    renderer.startRenderThread();
+  }
+
   // FPS calculation variables
   double lastTime = glfwGetTime();
   int frameCount = 0;
@@ -92,12 +235,30 @@ int main() {
   double lastFrameTime = lastTime;
 
   // Main rendering loop
+  bool hasPreviousFrame = false;
   while (!glfwWindowShouldClose(window)) {
+    PROFILE_ZONE("Frame");
+
     // Calculate FPS and delta time
     double currentTime = glfwGetTime();
     double deltaTime = currentTime - lastFrameTime;
     lastFrameTime = currentTime;
 
+    // Render thread mode: this thread only handles events, input and UI
+    if (renderer.isRenderThreadRunning()) {
+      {
+        PROFILE_ZONE("glfwPollEvents");
+        glfwPollEvents();
+      }
+      renderer.handleInput(deltaTime);
+
+      // A frame per snapshot the render thread can take, no UI work it would never draw
+      if (!renderer.submitFrame()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        continue;
+      }
+    }
+
     frameCount++;
 
     // Update FPS every second
@@ -112,17 +273,48 @@ int main() {
       glfwSetWindowTitle(window, title.str().c_str());
     }
 
+    if (renderer.isRenderThreadRunning()) {
+      continue;
+    }
+
     // Handle input
     renderer.handleInput(deltaTime);
 
-    renderer.render();
+    // Start preparing this frame on the workers, then present the previous one while they run
+    renderer.beginFrame();
+    if (hasPreviousFrame) {
+      PROFILE_ZONE("glfwSwapBuffers");
+      glfwSwapBuffers(window);
+    }
 
-    // Swap front and back buffers
-    glfwSwapBuffers(window);
+    renderer.render();
+    hasPreviousFrame = true;
 
     // Poll for and process events
-    glfwPollEvents();
+    {
+      PROFILE_ZONE("glfwPollEvents");
+      glfwPollEvents();
+    }
+
+    // Feed the benchmark with this frame's time, stop once all methods are measured
+    if (benchmarkMode && !benchmark.onFrame(renderer, glfwGetTime() - currentTime)) {
+      benchmark.printReport(std::cout);
+      glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+  }
+
+  // Joins the render thread and returns the context to this thread
+  renderer.stopRenderThread();
+
+#ifdef ENABLE_PROFILER
+  if (!tracePath.empty()) {
+    Profiler::writeChromeTrace(tracePath);
+  }
+#else
+  if (!tracePath.empty()) {
+    std::cerr << "--trace ignored: build with -DENABLE_PROFILER=ON" << std::endl;
   }
+#endif
 
   // Cleanup
   g_renderer = nullptr;
@@ -0,0 +1,122 @@
+#include "BenchmarkRunner.h"
+
+#include <algorithm>
+#include <iomanip>
+#include "Renderer.h"
+#include "../utils/GLCallCounter.h"
+
+BenchmarkRunner::BenchmarkRunner(int framesPerMethod, int warmupFrames)
+    : _framesPerMethod(framesPerMethod), _warmupFrames(warmupFrames), _runIndex(0), _frame(0), _statisticsSupported(false), _renderScale(1.0f), _cameraPath(false), _shadows(false),
+      _sphereTopology(SphereTopology::UV) {}
+
+void BenchmarkRunner::start(Renderer& renderer) {
+  _statisticsSupported = renderer.getPipelineStatistics().isSupported();
+  _renderScale = renderer.getRenderScale();
+  _cameraPath = renderer.isPlayingCameraPath();
+  _shadows = renderer.areShadowsEnabled();
+  _sphereTopology = renderer.getSphereTopology();
+
+  // Every method in grid order, then front to back to show the overdraw difference
+  _runs.clear();
+  for (DepthSortMode sortMode : {DepthSortMode::NONE, DepthSortMode::FRONT_TO_BACK}) {
+    for (int i = 0; i < RENDER_METHOD_COUNT; ++i) {
+      RunResult run;
+      run.method = static_cast<RenderMethod>(i);
+      run.sortMode = sortMode;
+      _runs.push_back(run);
+    }
+  }
+
+  _runIndex = 0;
+  _beginRun(renderer);
+}
+
+bool BenchmarkRunner::onFrame(Renderer& renderer, double frameTime) {
+  if (_runIndex >= _runs.size()) {
+    return false;
+  }
+
+  // Skip warmup frames so configuration switches and pipeline fills are not measured
+  RunResult& run = _runs[_runIndex];
+  if (_frame >= _warmupFrames) {
+    run.frames++;
+    run.totalFrameTime += frameTime;
+    run.totalSortTimeMs += renderer.getLastSortTimeMs();
+    run.totalGpuTimeMs += renderer.getLastGpuFrameMs();
+    run.totalShadowTimeMs += renderer.getLastShadowGpuMs();
+    const GLCallFrameStats& glCalls = renderer.getLastGLCallStats();
+    run.totalGLCalls += glCalls.calls;
+    run.totalDraws += glCalls.draws;
+    run.totalUploadBytes += glCalls.uploadBytes;
+  }
+  _frame++;
+
+  if (_frame < _warmupFrames + _framesPerMethod) {
+    return true;
+  }
+
+  // Statistics lag a few frames behind, by now they belong to this run
+  run.statistics = renderer.getPipelineStatistics().getResult(run.method);
+
+  // Move on to the next run
+  _runIndex++;
+  if (_runIndex >= _runs.size()) {
+    return false;
+  }
+
+  _beginRun(renderer);
+  return true;
+}
+
+void BenchmarkRunner::_beginRun(Renderer& renderer) {
+  _frame = 0;
+  renderer.setRenderMethod(_runs[_runIndex].method);
+  renderer.setDepthSortMode(_runs[_runIndex].sortMode);
+
+  // Every run flies the same views, frame for frame
+  renderer.restartCameraPath();
+}
+
+void BenchmarkRunner::printReport(std::ostream& out) const {
+  out << "=== Benchmark (" << _framesPerMethod << " frames per run, render scale " << std::setprecision(2) << _renderScale
+      << ", " << SPHERE_TOPOLOGY_NAMES[static_cast<int>(_sphereTopology)] << (_cameraPath ? ", camera path" : ", live camera") << ") ===" << std::endl;
+  out << std::left << std::setw(32) << "Method" << std::setw(24) << "Depth sort" << std::right << std::setw(10) << "Frame ms" << std::setw(10) << "Sort ms"
+      << std::setw(10) << "GPU ms";
+  if (_shadows) {
+    out << std::setw(12) << "Shadow ms";
+  }
+  if (GLCallCounter::isEnabled()) {
+    out << std::setw(10) << "GL calls" << std::setw(10) << "Draws" << std::setw(12) << "Upload KB";
+  }
+  if (_statisticsSupported) {
+    out << std::setw(14) << "Vertices" << std::setw(14) << "VS inv." << std::setw(14) << "Clip in" << std::setw(14) << "Clip out" << std::setw(14) << "FS inv."
+        << std::setw(14) << "TES inv.";
+  }
+  out << std::endl;
+
+  for (const RunResult& run : _runs) {
+    double averageMs = run.frames > 0 ? run.totalFrameTime * 1000.0 / run.frames : 0.0;
+    double averageSortMs = run.frames > 0 ? run.totalSortTimeMs / run.frames : 0.0;
+    double averageGpuMs = run.frames > 0 ? run.totalGpuTimeMs / run.frames : 0.0;
+    out << std::left << std::setw(32) << RENDER_METHOD_NAMES[static_cast<int>(run.method)] << std::setw(24) << DEPTH_SORT_MODE_NAMES[static_cast<int>(run.sortMode)]
+        << std::right << std::fixed << std::setprecision(3) << std::setw(10) << averageMs << std::setw(10) << averageSortMs << std::setw(10) << averageGpuMs;
+    if (_shadows) {
+      out << std::setw(12) << (run.frames > 0 ? run.totalShadowTimeMs / run.frames : 0.0);
+    }
+    if (GLCallCounter::isEnabled()) {
+      // Per-frame averages
+      int frames = std::max(run.frames, 1);
+      out << std::setw(10) << run.totalGLCalls / frames << std::setw(10) << run.totalDraws / frames << std::setw(12) << run.totalUploadBytes / 1024.0 / frames;
+    }
+    if (_statisticsSupported) {
+      const PipelineStatisticsResult& stats = run.statistics;
+      out << std::setw(14) << stats.verticesSubmitted << std::setw(14) << stats.vertexShaderInvocations << std::setw(14) << stats.clippingInputPrimitives << std::setw(14)
+          << stats.clippingOutputPrimitives << std::setw(14) << stats.fragmentShaderInvocations << std::setw(14) << stats.tessEvaluationInvocations;
+    }
+    out << std::endl;
+  }
+
+  if (!_statisticsSupported) {
+    out << "(pipeline statistics unavailable: ARB_pipeline_statistics_query not supported)" << std::endl;
+  }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "../geo/Sphere.h"
+#include "DepthSortMode.h"
+#include "PipelineStatistics.h"
+#include "RenderMethod.h"
+
+class Renderer;
+
+// Renders a fixed number of frames with every render method, unsorted and depth sorted,
+// and reports frame times, sort times, GPU times and GPU counters. Running it at several render
+// scales separates fill cost (scales with resolution) from vertex cost (does not).
+class BenchmarkRunner {
+public:
+  BenchmarkRunner(int framesPerMethod = 300, int warmupFrames = 30);
+
+  void start(Renderer& renderer);
+
+  // Call once per presented frame, returns false once every run has been measured
+  bool onFrame(Renderer& renderer, double frameTime);
+
+  void printReport(std::ostream& out) const;
+
+private:
+  struct RunResult {
+    RenderMethod method = RenderMethod::INSTANCED;
+    DepthSortMode sortMode = DepthSortMode::NONE;
+    int frames = 0;
+    double totalFrameTime = 0.0;
+    double totalSortTimeMs = 0.0;
+    double totalGpuTimeMs = 0.0;
+    double totalShadowTimeMs = 0.0;
+    uint64_t totalGLCalls = 0;  // Counting builds only
+    uint64_t totalDraws = 0;
+    uint64_t totalUploadBytes = 0;
+    PipelineStatisticsResult statistics;
+  };
+
+  int _framesPerMethod;
+  int _warmupFrames;
+  size_t _runIndex;
+  int _frame;
+  bool _statisticsSupported;
+  float _renderScale;
+  bool _cameraPath;  // Views come from a recorded path rather than the live camera
+  bool _shadows;
+  SphereTopology _sphereTopology;
+  std::vector<RunResult> _runs;
+
+  // Helper methods
+  void _beginRun(Renderer& renderer);
+};
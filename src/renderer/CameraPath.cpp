@@ -0,0 +1,104 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <glm/gtc/constants.hpp>
+
+bool CameraPath::load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "Failed to open camera path: " << path << std::endl;
+    return false;
+  }
+
+  std::vector<CameraKeyframe> keyframes;
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line)) {
+    lineNumber++;
+    size_t comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    CameraKeyframe keyframe;
+    std::istringstream fields(line);
+    if (!(fields >> keyframe.time >> keyframe.azimuth >> keyframe.elevation >> keyframe.distance >> keyframe.center.x >> keyframe.center.y >> keyframe.center.z)) {
+      std::cerr << "Invalid camera keyframe at " << path << ":" << lineNumber << std::endl;
+      return false;
+    }
+    if (!keyframes.empty() && keyframe.time < keyframes.back().time) {
+      std::cerr << "Camera keyframes out of order at " << path << ":" << lineNumber << std::endl;
+      return false;
+    }
+    keyframes.push_back(keyframe);
+  }
+
+  if (keyframes.empty()) {
+    std::cerr << "Camera path has no keyframes: " << path << std::endl;
+    return false;
+  }
+  _keyframes = std::move(keyframes);
+  return true;
+}
+
+bool CameraPath::save(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Failed to write camera path: " << path << std::endl;
+    return false;
+  }
+
+  file << "# time azimuth elevation distance centerX centerY centerZ" << std::endl;
+  file << std::setprecision(9);
+  for (const CameraKeyframe& keyframe : _keyframes) {
+    file << keyframe.time << ' ' << keyframe.azimuth << ' ' << keyframe.elevation << ' ' << keyframe.distance << ' ' << keyframe.center.x << ' '
+         << keyframe.center.y << ' ' << keyframe.center.z << '\n';
+  }
+  return static_cast<bool>(file);
+}
+
+CameraKeyframe CameraPath::sample(double time) const {
+  if (_keyframes.empty()) {
+    return CameraKeyframe();
+  }
+  double duration = getDuration();
+  if (_keyframes.size() == 1 || duration <= 0.0) {
+    return _keyframes.front();
+  }
+
+  // Loop so benchmark runs longer than the recording keep moving
+  time = std::fmod(std::max(0.0, time), duration);
+
+  // First keyframe after the time, the one before it starts the segment
+  auto next = std::upper_bound(_keyframes.begin(), _keyframes.end(), time, [](double t, const CameraKeyframe& keyframe) { return t < keyframe.time; });
+  next = std::max(std::min(next, _keyframes.end() - 1), _keyframes.begin() + 1);
+  const CameraKeyframe& a = *(next - 1);
+  const CameraKeyframe& b = *next;
+  double span = b.time - a.time;
+  float t = span > 0.0 ? static_cast<float>(std::clamp((time - a.time) / span, 0.0, 1.0)) : 1.0f;
+
+  // Azimuth is kept in [0, 2pi), interpolate across the wrap the short way
+  const float twoPi = 2.0f * glm::pi<float>();
+  float azimuthDelta = b.azimuth - a.azimuth;
+  if (azimuthDelta > glm::pi<float>()) {
+    azimuthDelta -= twoPi;
+  } else if (azimuthDelta < -glm::pi<float>()) {
+    azimuthDelta += twoPi;
+  }
+
+  CameraKeyframe result;
+  result.time = time;
+  result.azimuth = a.azimuth + azimuthDelta * t;
+  result.elevation = a.elevation + (b.elevation - a.elevation) * t;
+  result.distance = a.distance + (b.distance - a.distance) * t;
+  result.center = a.center + (b.center - a.center) * t;
+  return result;
+}
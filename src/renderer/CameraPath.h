@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Orbit camera state at a point in time
+struct CameraKeyframe {
+  double time = 0.0;  // Seconds from the start of the path
+  float azimuth = 0.0f;
+  float elevation = 0.0f;
+  float distance = 0.0f;
+  glm::vec3 center = glm::vec3(0.0f);
+};
+
+// Recorded orbit camera fly-through. Playback samples it at a fixed timestep per frame rather than
+// by wall-clock time, so frame N sees the same view in every run regardless of frame rate.
+// File format: text, one keyframe per line as "time azimuth elevation distance cx cy cz", '#' starts a comment.
+class CameraPath {
+public:
+  static constexpr double PLAYBACK_TIMESTEP = 1.0 / 60.0;
+
+  bool load(const std::string& path);
+  bool save(const std::string& path) const;
+
+  void clear() {
+    _keyframes.clear();
+  }
+  // Keyframes must be added in increasing time
+  void addKeyframe(const CameraKeyframe& keyframe) {
+    _keyframes.push_back(keyframe);
+  }
+
+  bool isEmpty() const {
+    return _keyframes.empty();
+  }
+  size_t getKeyframeCount() const {
+    return _keyframes.size();
+  }
+  double getDuration() const {
+    return _keyframes.empty() ? 0.0 : _keyframes.back().time;
+  }
+
+  // Interpolated state, wrapping around at the end of the path
+  CameraKeyframe sample(double time) const;
+  CameraKeyframe sampleFrame(long long frame) const {
+    return sample(frame * PLAYBACK_TIMESTEP);
+  }
+
+private:
+  std::vector<CameraKeyframe> _keyframes;
+};
@@ -0,0 +1,308 @@
+#include "ClusterCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Camera.h"
+#include "FramePipeline.h"
+#include "Frustum.h"
+#include "GLStateCache.h"
+#include "shaders/cluster_commands_compute.h"
+#include "shaders/cluster_cull_compute.h"
+#include "../utils/Profiler.h"
+#include "../utils/ShaderLoader.h"
+
+namespace {
+const GLuint WORKGROUP_SIZE = 64;
+
+GLuint buildComputeProgram(const std::string& source) {
+  GLuint shader = ShaderLoader::loadShaderFromSource(source, GL_COMPUTE_SHADER);
+  if (shader == 0) {
+    return 0;
+  }
+  return ShaderLoader::createComputeProgram(shader);
+}
+}  // namespace
+
+ClusterCuller::ClusterCuller()
+    : _lodCount(0), _lodFirstCluster{}, _lodClusterCount{}, _cullProgram(0), _commandProgram(0), _clusterBuffer(0), _countBuffer(0), _commandBuffer(0),
+      _instanceLists(0) {}
+
+ClusterCuller::~ClusterCuller() {
+  cleanup();
+}
+
+bool ClusterCuller::initialize() {
+  _cullProgram = buildComputeProgram(GeneratedShaders::CLUSTER_CULL_COMPUTE_SHADER);
+  _commandProgram = buildComputeProgram(GeneratedShaders::CLUSTER_COMMANDS_COMPUTE_SHADER);
+  if (_cullProgram == 0 || _commandProgram == 0) {
+    std::cerr << "Failed to create cluster culling programs" << std::endl;
+    cleanup();
+    return false;
+  }
+
+  glGenBuffers(1, &_clusterBuffer);
+  glGenBuffers(1, &_countBuffer);
+  glGenBuffers(1, &_commandBuffer);
+  if (_clusterBuffer == 0 || _countBuffer == 0 || _commandBuffer == 0) {
+    std::cerr << "Failed to generate cluster culling buffers" << std::endl;
+    cleanup();
+    return false;
+  }
+
+  return true;
+}
+
+void ClusterCuller::cleanup() {
+  for (GLuint* program : {&_cullProgram, &_commandProgram}) {
+    if (*program != 0) {
+      GLStateCache::deleteProgram(*program);
+      *program = 0;
+    }
+  }
+  for (GLuint* buffer : {&_clusterBuffer, &_countBuffer, &_commandBuffer}) {
+    if (*buffer != 0) {
+      GLStateCache::deleteBuffer(*buffer);
+      *buffer = 0;
+    }
+  }
+  _instanceLists.cleanup();
+}
+
+void ClusterCuller::buildClusters(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const SphereLod* lods, int lodCount) {
+  PROFILE_ZONE("ClusterCuller::buildClusters");
+
+  _clusters.clear();
+  _lodCount = lodCount;
+  for (int lod = 0; lod < lodCount; ++lod) {
+    _lods[lod] = lods[lod];
+    _lodFirstCluster[lod] = static_cast<uint32_t>(_clusters.size());
+    _buildLodClusters(vertices, indices, lods[lod], static_cast<uint32_t>(lod));
+    _lodClusterCount[lod] = static_cast<uint32_t>(_clusters.size()) - _lodFirstCluster[lod];
+  }
+
+  if (_clusterBuffer == 0) {
+    return;
+  }
+
+  // Static bounds, zeroed counters (the command pass resets them after each frame) and one command per cluster
+  std::vector<GLuint> zeroCounts(_clusters.size(), 0);
+  GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, _clusterBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, _clusters.size() * sizeof(SphereCluster), _clusters.data(), GL_STATIC_DRAW);
+  GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, _countBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, zeroCounts.size() * sizeof(GLuint), zeroCounts.data(), GL_DYNAMIC_COPY);
+  GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, _commandBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, _clusters.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+  GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ClusterCuller::_buildLodClusters(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const SphereLod& lod, uint32_t lodIndex) {
+  uint32_t triangleCount = lod.indexCount / 3;
+  const GLuint* lodIndices = &indices[lod.firstIndex];
+  const Vertex* lodVertices = &vertices[lod.baseVertex];
+  auto position = [&](GLuint index) { return glm::vec3(lodVertices[index].x, lodVertices[index].y, lodVertices[index].z); };
+
+  // Outward unit normals, oriented by the vertex normals; zero for degenerate triangles (pole rows)
+  std::vector<glm::vec3> normals(triangleCount, glm::vec3(0.0f));
+  GLuint vertexCount = 0;
+  for (uint32_t t = 0; t < triangleCount; ++t) {
+    const GLuint* corner = &lodIndices[t * 3];
+    glm::vec3 normal = glm::cross(position(corner[1]) - position(corner[0]), position(corner[2]) - position(corner[0]));
+    float length = glm::length(normal);
+    if (length > 1e-12f) {
+      glm::vec3 outward(0.0f);
+      for (int k = 0; k < 3; ++k) {
+        outward += glm::vec3(lodVertices[corner[k]].nx, lodVertices[corner[k]].ny, lodVertices[corner[k]].nz);
+      }
+      normals[t] = glm::dot(normal, outward) < 0.0f ? -normal / length : normal / length;
+    }
+    vertexCount = std::max({vertexCount, corner[0] + 1, corner[1] + 1, corner[2] + 1});
+  }
+
+  // Triangles around each vertex, clusters grow across shared vertices
+  std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+  for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+    adjacencyOffsets[lodIndices[i] + 1]++;
+  }
+  for (GLuint v = 0; v < vertexCount; ++v) {
+    adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+  }
+  std::vector<uint32_t> adjacency(triangleCount * 3);
+  std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+  for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+    adjacency[adjacencyFill[lodIndices[i]]++] = i / 3;
+  }
+
+  std::vector<uint8_t> assigned(triangleCount, 0);
+  std::vector<uint32_t> frontierStamp(triangleCount, UINT32_MAX);
+  std::vector<uint32_t> members;
+  std::vector<uint32_t> frontier;
+  std::vector<GLuint> reordered;
+  reordered.reserve(triangleCount * 3);
+
+  for (uint32_t seed = 0; seed < triangleCount; ++seed) {
+    if (assigned[seed]) {
+      continue;
+    }
+
+    uint32_t clusterId = static_cast<uint32_t>(_clusters.size());
+    members.clear();
+    frontier.clear();
+    glm::vec3 normalSum(0.0f);
+    auto addTriangle = [&](uint32_t t) {
+      assigned[t] = 1;
+      members.push_back(t);
+      normalSum += normals[t];
+      for (int k = 0; k < 3; ++k) {
+        GLuint v = lodIndices[t * 3 + k];
+        for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a) {
+          uint32_t neighbor = adjacency[a];
+          if (!assigned[neighbor] && frontierStamp[neighbor] != clusterId) {
+            frontierStamp[neighbor] = clusterId;
+            frontier.push_back(neighbor);
+          }
+        }
+      }
+    };
+
+    // Grow towards the neighbor closest to the running cone axis, keeping the cone narrow
+    addTriangle(seed);
+    while (members.size() < MAX_CLUSTER_TRIANGLES && !frontier.empty()) {
+      glm::vec3 axis = glm::length(normalSum) > 1e-6f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+      size_t best = 0;
+      float bestScore = -INFINITY;
+      for (size_t i = 0; i < frontier.size(); ++i) {
+        const glm::vec3& normal = normals[frontier[i]];
+        float score = normal == glm::vec3(0.0f) ? 1.0f : glm::dot(normal, axis);
+        if (score > bestScore) {
+          bestScore = score;
+          best = i;
+        }
+      }
+      uint32_t next = frontier[best];
+      frontier[best] = frontier.back();
+      frontier.pop_back();
+      addTriangle(next);
+    }
+
+    // Bounding sphere around the corners
+    glm::vec3 center(0.0f);
+    for (uint32_t t : members) {
+      for (int k = 0; k < 3; ++k) {
+        center += position(lodIndices[t * 3 + k]);
+      }
+    }
+    center /= static_cast<float>(members.size() * 3);
+    float radius = 0.0f;
+    for (uint32_t t : members) {
+      for (int k = 0; k < 3; ++k) {
+        radius = std::max(radius, glm::length(position(lodIndices[t * 3 + k]) - center));
+      }
+    }
+
+    // Normal cone, a half-angle of 90 degrees or more can never be back-facing as a whole
+    glm::vec3 axis(0.0f);
+    float cosHalfAngle = -1.0f;
+    if (glm::length(normalSum) > 1e-6f) {
+      axis = glm::normalize(normalSum);
+      cosHalfAngle = 1.0f;
+      for (uint32_t t : members) {
+        if (normals[t] != glm::vec3(0.0f)) {
+          cosHalfAngle = std::min(cosHalfAngle, glm::dot(normals[t], axis));
+        }
+      }
+      if (cosHalfAngle <= 0.0f) {
+        cosHalfAngle = -1.0f;
+      }
+    }
+
+    SphereCluster cluster;
+    cluster.boundingSphere = glm::vec4(center, radius);
+    cluster.cone = glm::vec4(axis, cosHalfAngle);
+    cluster.firstIndex = lod.firstIndex + static_cast<uint32_t>(reordered.size());
+    cluster.indexCount = static_cast<uint32_t>(members.size() * 3);
+    cluster.lod = lodIndex;
+    cluster.padding = 0;
+    _clusters.push_back(cluster);
+
+    for (uint32_t t : members) {
+      reordered.insert(reordered.end(), lodIndices + t * 3, lodIndices + t * 3 + 3);
+    }
+  }
+
+  // Same triangles, now contiguous per cluster
+  std::copy(reordered.begin(), reordered.end(), indices.begin() + lod.firstIndex);
+}
+
+void ClusterCuller::cull(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("ClusterCuller::cull");
+
+  if (_cullProgram == 0 || _clusters.empty() || frame.visibleCount == 0) {
+    return;
+  }
+
+  // The frame may have been prepared before a geometry change, ignore LODs that no longer exist
+  int lodCount = std::min(frame.lodCount, _lodCount);
+  GLuint visibleCount = frame.lodRanges[lodCount - 1].firstVisible + frame.lodRanges[lodCount - 1].count;
+
+  // Each cluster gets as many instance slots as its LOD has visible instances
+  GLuint instanceBase[MAX_SPHERE_LODS] = {};
+  size_t requiredEntries = 0;
+  for (int lod = 0; lod < lodCount; ++lod) {
+    instanceBase[lod] = static_cast<GLuint>(requiredEntries);
+    requiredEntries += static_cast<size_t>(_lodClusterCount[lod]) * frame.lodRanges[lod].count;
+  }
+  _instanceLists.reserve(requiredEntries * sizeof(GLuint));
+
+  // Bindings 0 (instance matrices) and 1 (visible indices) are set by the geometry renderer
+  GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _clusterBuffer);
+  GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _countBuffer);
+  GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _instanceLists.getBuffer());
+  GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _commandBuffer);
+
+  // Pass 1: per visible instance, append it to every cluster that survives the frustum and cone tests
+  glm::vec4 planes[6];
+  extractFrustumPlanes(camera.getProjectionMatrix() * camera.getViewMatrix(), planes);
+  GLStateCache::useProgram(_cullProgram);
+  glUniform4fv(glGetUniformLocation(_cullProgram, "frustumPlanes"), 6, glm::value_ptr(planes[0]));
+  glUniform3fv(glGetUniformLocation(_cullProgram, "cameraPosition"), 1, glm::value_ptr(camera.getPosition()));
+  glUniform1ui(glGetUniformLocation(_cullProgram, "visibleCount"), visibleCount);
+  glUniform1i(glGetUniformLocation(_cullProgram, "lodCount"), lodCount);
+  _setLodUniforms(_cullProgram, frame, instanceBase);
+  glDispatchCompute((visibleCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  // Pass 2: per cluster, write its draw command and reset its counter
+  GLuint clusterTotal = static_cast<GLuint>(_clusters.size());
+  GLint baseVertex[MAX_SPHERE_LODS] = {};
+  for (int lod = 0; lod < _lodCount; ++lod) {
+    baseVertex[lod] = _lods[lod].baseVertex;
+  }
+  GLStateCache::useProgram(_commandProgram);
+  glUniform1ui(glGetUniformLocation(_commandProgram, "clusterTotal"), clusterTotal);
+  glUniform1iv(glGetUniformLocation(_commandProgram, "lodBaseVertex"), MAX_SPHERE_LODS, baseVertex);
+  _setLodUniforms(_commandProgram, frame, instanceBase);
+  glDispatchCompute((clusterTotal + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ClusterCuller::_setLodUniforms(GLuint program, const PreparedFrame& frame, const GLuint (&instanceBase)[MAX_SPHERE_LODS]) const {
+  // LODs missing from the frame get no instances
+  int lodCount = std::min(frame.lodCount, _lodCount);
+  GLuint visible[MAX_SPHERE_LODS * 2] = {};
+  GLuint clusters[MAX_SPHERE_LODS * 2] = {};
+  for (int lod = 0; lod < _lodCount; ++lod) {
+    if (lod < lodCount) {
+      visible[lod * 2] = frame.lodRanges[lod].firstVisible;
+      visible[lod * 2 + 1] = frame.lodRanges[lod].count;
+    }
+    clusters[lod * 2] = _lodFirstCluster[lod];
+    clusters[lod * 2 + 1] = _lodClusterCount[lod];
+  }
+  glUniform2uiv(glGetUniformLocation(program, "lodVisible"), MAX_SPHERE_LODS, visible);
+  glUniform2uiv(glGetUniformLocation(program, "lodClusters"), MAX_SPHERE_LODS, clusters);
+  glUniform1uiv(glGetUniformLocation(program, "lodInstanceBase"), MAX_SPHERE_LODS, instanceBase);
+}
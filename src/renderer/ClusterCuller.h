@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "../geo/Sphere.h"
+#include "GpuBuffer.h"
+#include "SphereLod.h"
+
+// Forward declarations
+class Camera;
+struct PreparedFrame;
+
+// Triangle cluster of a sphere LOD with its culling bounds, same std430 layout as the compute shaders
+struct SphereCluster {
+  glm::vec4 boundingSphere;  // Object-space center, radius
+  glm::vec4 cone;            // Unit axis of the triangle normals, cosine of the half-angle (-1 when it cannot cull)
+  uint32_t firstIndex;       // In the shared EBO, LOD offset included
+  uint32_t indexCount;
+  uint32_t lod;
+  uint32_t padding;
+};
+
+// Splits the sphere LODs into clusters of up to 64 triangles and culls them per instance on the GPU.
+// A compute pass drops clusters outside the frustum or facing away from the camera (normal cone test)
+// and appends each instance to the lists of its surviving clusters; a second pass turns the lists into
+// one indirect draw per cluster, so back-facing triangles never reach the vertex shader.
+class ClusterCuller {
+public:
+  static const uint32_t MAX_CLUSTER_TRIANGLES = 64;
+
+  ClusterCuller();
+  ~ClusterCuller();
+
+  bool initialize();
+  void cleanup();
+
+  // Builds the clusters of every LOD and reorders each LOD's indices so a cluster is a contiguous range
+  void buildClusters(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const SphereLod* lods, int lodCount);
+
+  // Culls the clusters of the frame's visible instances, the command buffer is ready to draw afterwards
+  void cull(const PreparedFrame& frame, const Camera& camera);
+
+  // Instance indices per cluster, read through SSBO binding 1 with the command's baseInstance
+  GLuint getInstanceBuffer() const {
+    return _instanceLists.getBuffer();
+  }
+  // One DrawElementsIndirectCommand per cluster
+  GLuint getCommandBuffer() const {
+    return _commandBuffer;
+  }
+  GLsizei getClusterCount() const {
+    return static_cast<GLsizei>(_clusters.size());
+  }
+  uint32_t getLodClusterCount(int lod) const {
+    return _lodClusterCount[lod];
+  }
+
+private:
+  std::vector<SphereCluster> _clusters;
+  SphereLod _lods[MAX_SPHERE_LODS];
+  int _lodCount;
+  uint32_t _lodFirstCluster[MAX_SPHERE_LODS];
+  uint32_t _lodClusterCount[MAX_SPHERE_LODS];
+
+  GLuint _cullProgram;
+  GLuint _commandProgram;
+  GLuint _clusterBuffer;
+  GLuint _countBuffer;
+  GLuint _commandBuffer;
+  GpuBuffer _instanceLists;  // Written by the GPU only
+
+  // Helper methods
+  void _buildLodClusters(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const SphereLod& lod, uint32_t lodIndex);
+  void _setLodUniforms(GLuint program, const PreparedFrame& frame, const GLuint (&instanceBase)[MAX_SPHERE_LODS]) const;
+};
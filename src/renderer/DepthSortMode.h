@@ -0,0 +1,8 @@
+#pragma once
+
+// Per-frame ordering of instances by view depth
+// - FRONT_TO_BACK: 16-bit quantized depth keys, full radix sort
+// - BINNED: 64 coarse depth bins, one radix pass, grid order kept inside a bin
+enum class DepthSortMode { NONE = 0, FRONT_TO_BACK = 1, BINNED = 2 };
+
+const char* const DEPTH_SORT_MODE_NAMES[] = {"None (grid order)", "Front to Back", "Binned Front to Back"};
@@ -0,0 +1,434 @@
+#include "FramePipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "Frustum.h"
+#include "GLStateCache.h"
+#include "../utils/Profiler.h"
+#include "../utils/ThreadPool.h"
+
+namespace {
+  // Instances below this count are prepared on a single thread
+  const size_t PARALLEL_PREPARE_THRESHOLD = 4096;
+
+  // Projected radius in pixels below which LOD 1 and LOD 2 are used (before the bias)
+  const float LOD_PIXEL_THRESHOLDS[MAX_SPHERE_LODS - 1] = {24.0f, 8.0f};
+
+  const int LOD_KEY_BITS = 2;
+  const int DEPTH_KEY_BITS_SORTED = 16;
+  const int DEPTH_KEY_BITS_BINNED = 6;
+
+  double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+}  // namespace
+
+FramePipeline::FramePipeline()
+    : _frameIndex(0),
+      _currentSlot(nullptr),
+      _persistentMapping(false),
+      _pipelined(true),
+      _initialized(false),
+      _threadPool(nullptr),
+      _jobSlot(nullptr),
+      _jobPending(false),
+      _jobDone(false),
+      _stopping(false) {}
+
+FramePipeline::~FramePipeline() {
+  cleanup();
+}
+
+bool FramePipeline::initialize(ThreadPool* threadPool) {
+  _threadPool = threadPool;
+  _persistentMapping = GLEW_ARB_buffer_storage || GLEW_VERSION_4_4;
+
+  for (FrameSlot& slot : _slots) {
+    glGenBuffers(1, &slot.frame.indexBuffer);
+    glGenBuffers(1, &slot.frame.indirectBuffer);
+    if (slot.frame.indexBuffer == 0 || slot.frame.indirectBuffer == 0) {
+      std::cerr << "Failed to create frame pipeline buffers" << std::endl;
+      return false;
+    }
+    slot.stagingCommands.resize(MAX_SPHERE_LODS + 1);
+    _ensureCapacity(slot, 1);
+  }
+
+  _stopping = false;
+  _worker = std::thread(&FramePipeline::_workerLoop, this);
+  _initialized = true;
+  return true;
+}
+
+void FramePipeline::cleanup() {
+  if (_worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+    }
+    _jobCondition.notify_all();
+    _worker.join();
+  }
+
+  if (!_initialized) {
+    return;
+  }
+  for (FrameSlot& slot : _slots) {
+    _releaseSlot(slot);
+    GLStateCache::deleteBuffer(slot.frame.indexBuffer);
+    GLStateCache::deleteBuffer(slot.frame.indirectBuffer);
+    slot.frame.indexBuffer = 0;
+    slot.frame.indirectBuffer = 0;
+  }
+  _currentSlot = nullptr;
+  _initialized = false;
+}
+
+void FramePipeline::beginFrame(const FrameInputs& inputs) {
+  PROFILE_ZONE("FramePipeline::beginFrame");
+
+  FrameSlot& slot = _slots[_frameIndex % FRAMES_IN_FLIGHT];
+  _currentSlot = &slot;
+
+  // The GPU may still read this slot from FRAMES_IN_FLIGHT frames ago
+  _waitForSlot(slot);
+  _ensureCapacity(slot, inputs.instanceBounds ? inputs.instanceCount : 0);
+
+  if (!_pipelined) {
+    _prepare(slot, inputs);
+    _jobDone = true;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobInputs = inputs;
+    _jobSlot = &slot;
+    _jobPending = true;
+    _jobDone = false;
+  }
+  _jobCondition.notify_all();
+}
+
+const PreparedFrame& FramePipeline::acquireFrame() {
+  PROFILE_ZONE("FramePipeline::acquireFrame");
+
+  auto waitStart = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _jobCondition.wait(lock, [this] { return _jobDone; });
+  }
+  _stats.waitMs = millisecondsSince(waitStart);
+
+  FrameSlot& slot = *_currentSlot;
+  if (!_persistentMapping) {
+    // Without persistent mapping the preparation wrote to staging memory
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, slot.frame.indexBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, slot.frame.visibleCount * sizeof(uint32_t), slot.stagingIndices.data());
+
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, slot.frame.indirectBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, slot.stagingCommands.size() * sizeof(DrawElementsIndirectCommand), slot.stagingCommands.data());
+  }
+  return slot.frame;
+}
+
+void FramePipeline::endFrame() {
+  if (!_currentSlot) {
+    return;
+  }
+  _currentSlot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  _currentSlot = nullptr;
+  _frameIndex++;
+}
+
+void FramePipeline::_workerLoop() {
+  while (true) {
+    FrameSlot* slot = nullptr;
+    FrameInputs inputs;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _jobCondition.wait(lock, [this] { return _jobPending || _stopping; });
+      if (_stopping) {
+        return;
+      }
+      slot = _jobSlot;
+      inputs = _jobInputs;
+      _jobPending = false;
+    }
+
+    _prepare(*slot, inputs);
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _jobDone = true;
+    }
+    _jobCondition.notify_all();
+  }
+}
+
+void FramePipeline::_prepare(FrameSlot& slot, const FrameInputs& inputs) {
+  PROFILE_ZONE("FramePipeline::prepare");
+  auto start = std::chrono::steady_clock::now();
+
+  // Culling streams 16 bytes per instance from the bounds column instead of whole matrices
+  const glm::vec4* bounds = inputs.instanceBounds;
+  size_t count = bounds ? inputs.instanceCount : 0;
+  int lodCount = std::max(1, std::min(inputs.lodCount, MAX_SPHERE_LODS));
+
+  // Everything taken from the arena lives until the next preparation
+  _arena.reset();
+
+  _candidateIndices.resize(count);
+  _candidateDepths.resize(count);
+  _candidateLods.resize(count);
+
+  // Split the work into one chunk per thread
+  int chunkCount = _threadPool && count >= PARALLEL_PREPARE_THRESHOLD ? static_cast<int>(_threadPool->getThreadCount()) : 1;
+  auto forEachChunk = [&](const auto& kernel) {
+    auto runChunk = [&](int chunk) { kernel(chunk, count * chunk / chunkCount, count * (chunk + 1) / chunkCount); };
+    if (chunkCount > 1) {
+      _threadPool->parallelFor(chunkCount, runChunk);
+    } else {
+      runChunk(0);
+    }
+  };
+
+  // Frustum planes for the sphere tests
+  glm::vec4 planes[6];
+  extractFrustumPlanes(inputs.projectionMatrix * inputs.viewMatrix, planes);
+
+  // View depth of a point: -(view * p).z
+  const glm::mat4& view = inputs.viewMatrix;
+  glm::vec4 depthRow(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+
+  // Projected radius in pixels = radius * pixelsPerUnit / depth
+  float pixelsPerUnit = 0.5f * inputs.viewportHeight * inputs.projectionMatrix[1][1];
+  float lodScale = std::exp2(inputs.lodBias);
+
+  // Pass 1: cull, pick a LOD and compact the survivors within each chunk
+  size_t* chunkVisible = _arena.allocateFilled<size_t>(chunkCount, 0);
+  float* chunkMin = _arena.allocateFilled<float>(chunkCount, INFINITY);
+  float* chunkMax = _arena.allocateFilled<float>(chunkCount, -INFINITY);
+  uint32_t* chunkLodCounts = _arena.allocateFilled<uint32_t>(chunkCount * MAX_SPHERE_LODS, 0);
+  forEachChunk([&](int chunk, size_t begin, size_t end) {
+    uint32_t* lodCounts = &chunkLodCounts[chunk * MAX_SPHERE_LODS];
+    size_t visible = begin;
+    float minDepth = INFINITY;
+    float maxDepth = -INFINITY;
+    for (size_t i = begin; i < end; ++i) {
+      glm::vec4 center = glm::vec4(glm::vec3(bounds[i]), 1.0f);
+      float radius = inputs.sphereRadius * bounds[i].w;
+
+      if (inputs.frustumCulling && !sphereInFrustum(planes, center, radius)) {
+        continue;
+      }
+
+      float depth = glm::dot(depthRow, center);
+      uint8_t lod = 0;
+      if (inputs.lodSelection) {
+        float pixelRadius = depth > 0.0f ? radius * pixelsPerUnit / depth : INFINITY;
+        while (lod + 1 < lodCount && pixelRadius < LOD_PIXEL_THRESHOLDS[lod] * lodScale) {
+          lod++;
+        }
+      }
+
+      _candidateIndices[visible] = static_cast<uint32_t>(i);
+      _candidateDepths[visible] = depth;
+      _candidateLods[visible] = lod;
+      lodCounts[lod]++;
+      visible++;
+      minDepth = std::min(minDepth, depth);
+      maxDepth = std::max(maxDepth, depth);
+    }
+    chunkVisible[chunk] = visible - begin;
+    chunkMin[chunk] = minDepth;
+    chunkMax[chunk] = maxDepth;
+  });
+
+  size_t* chunkOffsets = _arena.allocate<size_t>(chunkCount);
+  size_t visibleCount = 0;
+  for (int chunk = 0; chunk < chunkCount; ++chunk) {
+    chunkOffsets[chunk] = visibleCount;
+    visibleCount += chunkVisible[chunk];
+  }
+  float minDepth = *std::min_element(chunkMin, chunkMin + chunkCount);
+  float maxDepth = *std::max_element(chunkMax, chunkMax + chunkCount);
+
+  // Key layout: LOD in the high bits groups the draws per LOD, depth below orders each group
+  int depthBits = 0;
+  if (inputs.sortMode == DepthSortMode::FRONT_TO_BACK) {
+    depthBits = DEPTH_KEY_BITS_SORTED;
+  } else if (inputs.sortMode == DepthSortMode::BINNED) {
+    depthBits = DEPTH_KEY_BITS_BINNED;
+  }
+  int keyBits = depthBits + (inputs.lodSelection ? LOD_KEY_BITS : 0);
+  float depthScale = depthBits > 0 && maxDepth > minDepth ? static_cast<float>((1u << depthBits) - 1) / (maxDepth - minDepth) : 0.0f;
+
+  // Pass 2: gather the survivors of every chunk into one contiguous list
+  _sortKeys.resize(visibleCount);
+  _sortValues.resize(visibleCount);
+  uint32_t* outputIndices = _persistentMapping ? slot.indices : slot.stagingIndices.data();
+  uint32_t* values = keyBits > 0 ? _sortValues.data() : outputIndices;
+  forEachChunk([&](int chunk, size_t begin, size_t) {
+    size_t destination = chunkOffsets[chunk];
+    for (size_t j = 0; j < chunkVisible[chunk]; ++j) {
+      size_t source = begin + j;
+      uint32_t depthKey = static_cast<uint32_t>((_candidateDepths[source] - minDepth) * depthScale);
+      _sortKeys[destination + j] = (static_cast<uint32_t>(_candidateLods[source]) << depthBits) | depthKey;
+      values[destination + j] = _candidateIndices[source];
+    }
+  });
+
+  uint32_t lodCounts[MAX_SPHERE_LODS] = {};
+  for (int chunk = 0; chunk < chunkCount; ++chunk) {
+    for (int lod = 0; lod < MAX_SPHERE_LODS; ++lod) {
+      lodCounts[lod] += chunkLodCounts[chunk * MAX_SPHERE_LODS + lod];
+    }
+  }
+
+  double sortMs = 0.0;
+  if (keyBits > 0 && visibleCount > 0) {
+    auto sortStart = std::chrono::steady_clock::now();
+    _sorter.sort(_sortKeys.data(), _sortValues.data(), visibleCount, keyBits, chunkCount > 1 ? _threadPool : nullptr);
+    std::memcpy(outputIndices, _sortValues.data(), visibleCount * sizeof(uint32_t));
+    sortMs = millisecondsSince(sortStart);
+  }
+
+  // Per-LOD ranges and draw commands
+  PreparedFrame& frame = slot.frame;
+  DrawElementsIndirectCommand* commands = _persistentMapping ? slot.commands : slot.stagingCommands.data();
+  uint32_t firstVisible = 0;
+  for (int lod = 0; lod < lodCount; ++lod) {
+    frame.lodRanges[lod].firstVisible = firstVisible;
+    frame.lodRanges[lod].count = lodCounts[lod];
+
+    const SphereLod& sphereLod = inputs.lods[lod];
+    commands[lod] = {sphereLod.indexCount, lodCounts[lod], sphereLod.firstIndex, sphereLod.baseVertex, firstVisible};
+    firstVisible += lodCounts[lod];
+  }
+  for (int lod = lodCount; lod < MAX_SPHERE_LODS; ++lod) {
+    frame.lodRanges[lod] = LodRange();
+    commands[lod] = {0, 0, 0, 0, 0};
+  }
+
+  // Paths that cannot read the visible list draw every instance with LOD 0
+  const SphereLod& fullLod = inputs.lods[0];
+  commands[MAX_SPHERE_LODS] = {fullLod.indexCount, static_cast<GLuint>(count), fullLod.firstIndex, fullLod.baseVertex, 0};
+
+  frame.visibleCount = static_cast<uint32_t>(visibleCount);
+  frame.totalCount = static_cast<uint32_t>(count);
+  frame.lodCount = lodCount;
+  frame.viewportHeight = inputs.viewportHeight;
+  frame.lodBias = inputs.lodBias;
+
+  // Read by the main thread only after acquireFrame synchronized with this preparation
+  _stats.prepareMs = millisecondsSince(start);
+  _stats.sortMs = sortMs;
+  _stats.visibleCount = frame.visibleCount;
+  _stats.arenaBytes = _arena.getUsedBytes();
+  std::copy(lodCounts, lodCounts + MAX_SPHERE_LODS, _stats.lodCounts);
+}
+
+void FramePipeline::_waitForSlot(FrameSlot& slot) {
+  if (!slot.fence) {
+    _stats.fenceWaitMs = 0.0;
+    return;
+  }
+
+  PROFILE_ZONE("FramePipeline::waitForSlot");
+  auto start = std::chrono::steady_clock::now();
+  GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  while (result == GL_TIMEOUT_EXPIRED) {
+    result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+  }
+  if (result == GL_WAIT_FAILED) {
+    std::cerr << "Frame fence wait failed" << std::endl;
+  }
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  _stats.fenceWaitMs = millisecondsSince(start);
+}
+
+void FramePipeline::_ensureCapacity(FrameSlot& slot, size_t instanceCount) {
+  if (instanceCount <= slot.capacity) {
+    return;
+  }
+
+  // Grow geometrically so a slowly rising instance count does not reallocate every frame
+  size_t capacity = std::max(instanceCount, slot.capacity * 2);
+  size_t indexBytes = capacity * sizeof(uint32_t);
+  size_t commandBytes = (MAX_SPHERE_LODS + 1) * sizeof(DrawElementsIndirectCommand);
+
+  if (!_persistentMapping) {
+    slot.stagingIndices.resize(capacity);
+
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, slot.frame.indexBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, indexBytes, nullptr, GL_STREAM_DRAW);
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, slot.frame.indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, nullptr, GL_STREAM_DRAW);
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    slot.capacity = capacity;
+    return;
+  }
+
+  // Immutable storage cannot be resized, replace the buffers
+  _releaseSlot(slot);
+  GLStateCache::deleteBuffer(slot.frame.indexBuffer);
+  GLStateCache::deleteBuffer(slot.frame.indirectBuffer);
+  glGenBuffers(1, &slot.frame.indexBuffer);
+  glGenBuffers(1, &slot.frame.indirectBuffer);
+
+  // Coherent mapping: worker writes are visible to draws issued after acquireFrame without explicit flushes
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, slot.frame.indexBuffer);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, indexBytes, nullptr, flags);
+  slot.indices = static_cast<uint32_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, indexBytes, flags));
+  GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, slot.frame.indirectBuffer);
+  glBufferStorage(GL_DRAW_INDIRECT_BUFFER, commandBytes, nullptr, flags);
+  slot.commands = static_cast<DrawElementsIndirectCommand*>(glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, commandBytes, flags));
+  GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  if (!slot.indices || !slot.commands) {
+    // Fall back to staging uploads for every slot
+    std::cerr << "Failed to map frame pipeline buffers persistently, using uploads" << std::endl;
+    _persistentMapping = false;
+    for (FrameSlot& other : _slots) {
+      _releaseSlot(other);
+      GLStateCache::deleteBuffer(other.frame.indexBuffer);
+      GLStateCache::deleteBuffer(other.frame.indirectBuffer);
+      glGenBuffers(1, &other.frame.indexBuffer);
+      glGenBuffers(1, &other.frame.indirectBuffer);
+      other.capacity = 0;
+    }
+    _ensureCapacity(slot, instanceCount);
+    return;
+  }
+  slot.capacity = capacity;
+}
+
+void FramePipeline::_releaseSlot(FrameSlot& slot) {
+  if (slot.fence) {
+    glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+  }
+  if (slot.indices) {
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, slot.frame.indexBuffer);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    slot.indices = nullptr;
+  }
+  if (slot.commands) {
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, slot.frame.indirectBuffer);
+    glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    slot.commands = nullptr;
+  }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "../utils/FrameArena.h"
+#include "../utils/RadixSort.h"
+#include "DepthSortMode.h"
+#include "SphereLod.h"
+
+class ThreadPool;
+
+// Layout mandated by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+  GLuint count;          // Number of elements to draw
+  GLuint instanceCount;  // Number of instances
+  GLuint firstIndex;     // Offset into index buffer
+  GLint baseVertex;      // Offset into vertex buffer
+  GLuint baseInstance;   // Offset into the visible index list (gl_BaseInstance)
+};
+
+// Everything the CPU preparation of a frame reads, copied so the worker never touches live renderer state
+struct FrameInputs {
+  const glm::vec4* instanceBounds = nullptr;  // Bounds column of the instance attributes, must not change until acquireFrame returns
+  size_t instanceCount = 0;
+  glm::mat4 viewMatrix = glm::mat4(1.0f);
+  glm::mat4 projectionMatrix = glm::mat4(1.0f);
+  float viewportHeight = 1.0f;
+  float sphereRadius = 0.0f;
+  SphereLod lods[MAX_SPHERE_LODS];
+  int lodCount = 0;
+
+  bool frustumCulling = false;
+  bool lodSelection = false;
+  float lodBias = 0.0f;  // Positive values switch to coarser LODs earlier
+  DepthSortMode sortMode = DepthSortMode::NONE;
+};
+
+// Range of the visible index list drawn with one LOD
+struct LodRange {
+  uint32_t firstVisible = 0;
+  uint32_t count = 0;
+};
+
+// CPU-built draw data for one frame, backed by that frame's GPU buffers
+struct PreparedFrame {
+  GLuint indexBuffer = 0;     // Visible instance indices grouped by LOD (SSBO binding 1)
+  GLuint indirectBuffer = 0;  // One command per LOD, then one command drawing every instance with LOD 0
+  uint32_t visibleCount = 0;
+  uint32_t totalCount = 0;
+  LodRange lodRanges[MAX_SPHERE_LODS];
+  int lodCount = 0;
+
+  // Screen-space detail inputs, for paths that pick the detail on the GPU
+  float viewportHeight = 1.0f;
+  float lodBias = 0.0f;
+};
+
+struct FramePipelineStats {
+  double prepareMs = 0.0;    // CPU preparation time (culling, LOD, sort, command build)
+  double sortMs = 0.0;       // Part of prepareMs spent in the radix sort
+  double waitMs = 0.0;       // Main thread blocked waiting for the preparation
+  double fenceWaitMs = 0.0;  // Main thread blocked waiting for the GPU to release a frame slot
+  uint32_t visibleCount = 0;
+  uint32_t lodCounts[MAX_SPHERE_LODS] = {};
+  size_t arenaBytes = 0;  // Frame arena use of the last preparation
+};
+
+// Prepares frame N+1 on a worker thread while the GPU consumes frame N.
+// Per-frame buffers are triple-buffered and guarded by fences; with ARB_buffer_storage they are
+// persistently mapped and written directly by the workers, otherwise uploaded on acquire.
+// The worker is the only user of the thread pool while a preparation is in flight.
+class FramePipeline {
+public:
+  static const int FRAMES_IN_FLIGHT = 3;
+
+  FramePipeline();
+  ~FramePipeline();
+
+  bool initialize(ThreadPool* threadPool);
+  void cleanup();
+
+  // Main thread: starts preparing a frame, on the worker when pipelined, inline otherwise
+  void beginFrame(const FrameInputs& inputs);
+  // Main thread: waits for the preparation and makes its buffers visible to the GPU
+  const PreparedFrame& acquireFrame();
+  // Main thread: fences the frame's buffers once its draws are submitted
+  void endFrame();
+
+  void setPipelined(bool pipelined) {
+    _pipelined = pipelined;
+  }
+  bool isPipelined() const {
+    return _pipelined;
+  }
+  bool isPersistentlyMapped() const {
+    return _persistentMapping;
+  }
+  const FramePipelineStats& getStats() const {
+    return _stats;
+  }
+
+private:
+  struct FrameSlot {
+    PreparedFrame frame;
+    GLsync fence = nullptr;
+    size_t capacity = 0;
+
+    // Destinations written by the preparation: mapped GPU memory or staging for upload
+    uint32_t* indices = nullptr;
+    DrawElementsIndirectCommand* commands = nullptr;
+    std::vector<uint32_t> stagingIndices;
+    std::vector<DrawElementsIndirectCommand> stagingCommands;
+  };
+
+  FrameSlot _slots[FRAMES_IN_FLIGHT];
+  unsigned int _frameIndex;
+  FrameSlot* _currentSlot;
+  bool _persistentMapping;
+  bool _pipelined;
+  bool _initialized;
+  ThreadPool* _threadPool;
+  FramePipelineStats _stats;
+
+  // Worker thread handoff
+  std::thread _worker;
+  std::mutex _mutex;
+  std::condition_variable _jobCondition;
+  FrameInputs _jobInputs;
+  FrameSlot* _jobSlot;
+  bool _jobPending;
+  bool _jobDone;
+  bool _stopping;
+
+  // Preparation scratch, only touched by whoever runs _prepare
+  std::vector<uint32_t> _candidateIndices;
+  std::vector<float> _candidateDepths;
+  std::vector<uint8_t> _candidateLods;
+  std::vector<uint32_t> _sortKeys;
+  std::vector<uint32_t> _sortValues;
+  RadixSorter _sorter;
+  FrameArena _arena;
+
+  // Helper methods
+  void _workerLoop();
+  void _prepare(FrameSlot& slot, const FrameInputs& inputs);
+  void _waitForSlot(FrameSlot& slot);
+  void _ensureCapacity(FrameSlot& slot, size_t instanceCount);
+  void _releaseSlot(FrameSlot& slot);
+};
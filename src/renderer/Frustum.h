@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Frustum planes of a view-projection matrix (Gribb/Hartmann), normalized for sphere tests:
+// a sphere is outside when dot(plane, center) < -radius for any plane
+inline void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 (&planes)[6]) {
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; ++i) {
+    rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+  }
+  planes[0] = rows[3] + rows[0];
+  planes[1] = rows[3] - rows[0];
+  planes[2] = rows[3] + rows[1];
+  planes[3] = rows[3] - rows[1];
+  planes[4] = rows[3] + rows[2];
+  planes[5] = rows[3] - rows[2];
+  for (glm::vec4& plane : planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+}
+
+// Whether a sphere is at least partly inside the planes of extractFrustumPlanes
+inline bool sphereInFrustum(const glm::vec4 (&planes)[6], const glm::vec4& center, float radius) {
+  for (const glm::vec4& plane : planes) {
+    if (glm::dot(plane, center) < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,178 @@
+#include "GLStateCache.h"
+
+#include <GL/glew.h>
+
+// A fresh context has everything unbound, which is what zero-initialization records
+unsigned int GLStateCache::_program = 0;
+unsigned int GLStateCache::_vertexArray = 0;
+unsigned int GLStateCache::_buffers[BUFFER_TARGET_COUNT] = {};
+unsigned int GLStateCache::_storageBindings[INDEXED_BINDING_COUNT] = {};
+unsigned int GLStateCache::_activeUnit = 0;
+unsigned int GLStateCache::_textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT] = {};
+GLStateCacheStats GLStateCache::_stats;
+
+void GLStateCache::useProgram(unsigned int program) {
+  if (_changes(_program, program)) {
+    glUseProgram(program);
+  }
+}
+
+void GLStateCache::bindVertexArray(unsigned int vertexArray) {
+  if (_changes(_vertexArray, vertexArray)) {
+    glBindVertexArray(vertexArray);
+  }
+}
+
+void GLStateCache::bindBuffer(unsigned int target, unsigned int buffer) {
+  int slot = _bufferSlot(target);
+  if (slot < 0) {
+    _stats.issued++;
+    glBindBuffer(target, buffer);
+    return;
+  }
+  if (_changes(_buffers[slot], buffer)) {
+    glBindBuffer(target, buffer);
+  }
+}
+
+void GLStateCache::bindBufferBase(unsigned int target, unsigned int index, unsigned int buffer) {
+  if (target == GL_SHADER_STORAGE_BUFFER && index < INDEXED_BINDING_COUNT) {
+    if (!_changes(_storageBindings[index], buffer)) {
+      return;
+    }
+  } else {
+    _stats.issued++;
+  }
+  glBindBufferBase(target, index, buffer);
+
+  // Binding an indexed point also binds the generic target
+  int slot = _bufferSlot(target);
+  if (slot >= 0) {
+    _buffers[slot] = buffer;
+  }
+}
+
+void GLStateCache::bindTexture(unsigned int unit, unsigned int target, unsigned int texture) {
+  int slot = _textureSlot(target);
+  if (slot < 0 || unit >= TEXTURE_UNIT_COUNT) {
+    _activateUnit(unit);
+    _stats.issued++;
+    glBindTexture(target, texture);
+    return;
+  }
+  if (_textures[unit][slot] == texture) {
+    _stats.skipped++;
+    return;
+  }
+  _activateUnit(unit);
+  _textures[unit][slot] = texture;
+  _stats.issued++;
+  glBindTexture(target, texture);
+}
+
+void GLStateCache::deleteProgram(unsigned int program) {
+  // A deleted program stays in use until replaced, and its name may come back for a new one
+  if (_program == program) {
+    _program = UNKNOWN;
+  }
+  glDeleteProgram(program);
+}
+
+void GLStateCache::deleteVertexArray(unsigned int vertexArray) {
+  if (_vertexArray == vertexArray) {
+    _vertexArray = 0;
+  }
+  glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLStateCache::deleteBuffer(unsigned int buffer) {
+  // Drivers differ on indexed bindings of deleted buffers, so forget rather than assume zero
+  for (unsigned int& bound : _buffers) {
+    if (bound == buffer) {
+      bound = UNKNOWN;
+    }
+  }
+  for (unsigned int& bound : _storageBindings) {
+    if (bound == buffer) {
+      bound = UNKNOWN;
+    }
+  }
+  glDeleteBuffers(1, &buffer);
+}
+
+void GLStateCache::deleteTexture(unsigned int texture) {
+  for (auto& unit : _textures) {
+    for (unsigned int& bound : unit) {
+      if (bound == texture) {
+        bound = UNKNOWN;
+      }
+    }
+  }
+  glDeleteTextures(1, &texture);
+}
+
+void GLStateCache::invalidate() {
+  _program = UNKNOWN;
+  _vertexArray = UNKNOWN;
+  for (unsigned int& bound : _buffers) {
+    bound = UNKNOWN;
+  }
+  for (unsigned int& bound : _storageBindings) {
+    bound = UNKNOWN;
+  }
+  _activeUnit = UNKNOWN;
+  for (auto& unit : _textures) {
+    for (unsigned int& bound : unit) {
+      bound = UNKNOWN;
+    }
+  }
+}
+
+void GLStateCache::beginFrame() {
+  invalidate();
+  _stats = GLStateCacheStats();
+}
+
+bool GLStateCache::_changes(unsigned int& cached, unsigned int value) {
+  if (cached == value) {
+    _stats.skipped++;
+    return false;
+  }
+  cached = value;
+  _stats.issued++;
+  return true;
+}
+
+void GLStateCache::_activateUnit(unsigned int unit) {
+  if (_changes(_activeUnit, unit)) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+  }
+}
+
+int GLStateCache::_bufferSlot(unsigned int target) {
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      return 0;
+    case GL_COPY_WRITE_BUFFER:
+      return 1;
+    case GL_DRAW_INDIRECT_BUFFER:
+      return 2;
+    case GL_SHADER_STORAGE_BUFFER:
+      return 3;
+    default:
+      return -1;
+  }
+}
+
+int GLStateCache::_textureSlot(unsigned int target) {
+  switch (target) {
+    case GL_TEXTURE_2D:
+      return 0;
+    case GL_TEXTURE_2D_ARRAY:
+      return 1;
+    case GL_TEXTURE_BUFFER:
+      return 2;
+    default:
+      return -1;
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Binds issued to the driver and binds skipped because the state was already set
+struct GLStateCacheStats {
+  unsigned int issued = 0;
+  unsigned int skipped = 0;
+};
+
+// Shadow copy of the program, vertex array, buffer and texture bindings of the one GL context, so
+// binding what is already bound costs nothing. Every bind of a tracked kind must go through here,
+// as must deletes of bound objects; code outside the renderer (ImGui) is covered by beginFrame
+// forgetting everything. Targets and units that are not tracked are passed straight through.
+// The element array buffer is vertex array state and is never cached.
+class GLStateCache {
+public:
+  static void useProgram(unsigned int program);
+  static void bindVertexArray(unsigned int vertexArray);
+  static void bindBuffer(unsigned int target, unsigned int buffer);
+  static void bindBufferBase(unsigned int target, unsigned int index, unsigned int buffer);
+  static void bindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+
+  // Delete the object and drop every binding that referred to it, as GL does
+  static void deleteProgram(unsigned int program);
+  static void deleteVertexArray(unsigned int vertexArray);
+  static void deleteBuffer(unsigned int buffer);
+  static void deleteTexture(unsigned int texture);
+
+  // Forgets all bindings, the next bind of each kind is always issued
+  static void invalidate();
+
+  // Invalidates and restarts the per-frame counters
+  static void beginFrame();
+  static const GLStateCacheStats& getFrameStats() {
+    return _stats;
+  }
+
+private:
+  static constexpr unsigned int UNKNOWN = ~0u;
+  static constexpr int BUFFER_TARGET_COUNT = 4;
+  static constexpr int INDEXED_BINDING_COUNT = 8;  // Shader storage binding points
+  static constexpr int TEXTURE_TARGET_COUNT = 3;
+  static constexpr int TEXTURE_UNIT_COUNT = 4;
+
+  static unsigned int _program;
+  static unsigned int _vertexArray;
+  static unsigned int _buffers[BUFFER_TARGET_COUNT];
+  static unsigned int _storageBindings[INDEXED_BINDING_COUNT];
+  static unsigned int _activeUnit;
+  static unsigned int _textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT];
+  static GLStateCacheStats _stats;
+
+  // Helper methods
+  static bool _changes(unsigned int& cached, unsigned int value);
+  static void _activateUnit(unsigned int unit);
+  static int _bufferSlot(unsigned int target);
+  static int _textureSlot(unsigned int target);
+};
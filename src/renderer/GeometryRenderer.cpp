@@ -1,15 +1,93 @@
 #include "GeometryRenderer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Camera.h"
+#include "FramePipeline.h"
+#include "GLStateCache.h"
 #include "InstanceManager.h"
 #include "ShaderManager.h"
+#include "../utils/Profiler.h"
 
-GeometryRenderer::GeometryRenderer() : _sphereVAO(0), _sphereVBO(0), _sphereEBO(0), _instanceSSBO(0), _indirectBuffer(0) {}
+namespace {
+// Compressed vertex layouts, see VertexFormat.h
+struct Snorm16Vertex {
+  int16_t x, y, z, pad;
+};
+
+struct OctahedralVertex {
+  int16_t u, v;
+};
+
+int16_t toSnorm16(float value) {
+  return static_cast<int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f));
+}
+
+// Octahedral projection of a unit vector onto [-1, 1]^2
+OctahedralVertex encodeOctahedral(float x, float y, float z) {
+  float invL1 = 1.0f / (std::fabs(x) + std::fabs(y) + std::fabs(z));
+  float u = x * invL1;
+  float v = y * invL1;
+  if (z < 0.0f) {
+    float foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+    float foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+    u = foldedU;
+    v = foldedV;
+  }
+  return {toSnorm16(u), toSnorm16(v)};
+}
+
+// Re-encodes float vertices into the selected format; the normal is the unit position on a sphere
+std::vector<uint8_t> packVertices(const std::vector<Vertex>& vertices, VertexFormat format) {
+  std::vector<uint8_t> packed(vertices.size() * getVertexStride(format));
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const Vertex& vertex = vertices[i];
+    switch (format) {
+      case VertexFormat::SNORM16: {
+        Snorm16Vertex out = {toSnorm16(vertex.nx), toSnorm16(vertex.ny), toSnorm16(vertex.nz), 0};
+        std::memcpy(&packed[i * sizeof(out)], &out, sizeof(out));
+        break;
+      }
+      case VertexFormat::OCTAHEDRAL: {
+        OctahedralVertex out = encodeOctahedral(vertex.nx, vertex.ny, vertex.nz);
+        std::memcpy(&packed[i * sizeof(out)], &out, sizeof(out));
+        break;
+      }
+      default:
+        std::memcpy(&packed[i * sizeof(Vertex)], &vertex, sizeof(Vertex));
+        break;
+    }
+  }
+  return packed;
+}
+
+// Same direction as the light in the fragment shaders
+const glm::vec3 SHADOW_LIGHT_DIRECTION = glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f));
+
+// View distance covered by the shadow cascades
+const float SHADOW_DISTANCE = 60.0f;
+
+// Texture unit of the shadow map, unit 0 belongs to the instance texture buffer
+const GLint SHADOW_TEXTURE_UNIT = 1;
+
+// Tessellated spheres stay within this many pixels of the true silhouette, scaled by 2^lodBias
+const float TESSELLATION_ERROR_PIXELS = 0.5f;
+
+// Eight triangular patches of the base octahedron
+const GLsizei OCTAHEDRON_PATCH_VERTICES = 24;
+}  // namespace
+
+GeometryRenderer::GeometryRenderer()
+    : _sphereLodCount(0), _sphereRadius(0.0f), _sphereSegments(0), _sphereTopology(SphereTopology::UV), _sphereVAO(0), _emptyVAO(0), _sphereVBO(0), _sphereEBO(0), _instanceTBO(0),
+      _instanceDataSource(InstanceDataSource::SSBO), _vertexFormat(VertexFormat::FLOAT32), _vertexBufferBytes(0), _clusterCullingAvailable(false),
+      _shadowsEnabled(false) {}
 
 GeometryRenderer::~GeometryRenderer() {
   cleanup();
@@ -18,7 +96,8 @@ GeometryRenderer::~GeometryRenderer() {
 bool GeometryRenderer::initialize() {
   // Generate VAOs
   glGenVertexArrays(1, &_sphereVAO);
-  if (_sphereVAO == 0) {
+  glGenVertexArrays(1, &_emptyVAO);
+  if (_sphereVAO == 0 || _emptyVAO == 0) {
     std::cerr << "Failed to generate VAO" << std::endl;
     return false;
   }
@@ -26,191 +105,443 @@ bool GeometryRenderer::initialize() {
   // Generate buffers
   glGenBuffers(1, &_sphereVBO);
   glGenBuffers(1, &_sphereEBO);
-  glGenBuffers(1, &_instanceSSBO);
-  glGenBuffers(1, &_indirectBuffer);
 
-  if (_sphereVBO == 0 || _sphereEBO == 0 || _instanceSSBO == 0 || _indirectBuffer == 0) {
-    std::cerr << "Failed to generate VBO/EBO/SSBO/IndirectBuffer" << std::endl;
+  // Texture view of the instance buffer for texel fetch
+  glGenTextures(1, &_instanceTBO);
+
+  if (_sphereVBO == 0 || _sphereEBO == 0 || _instanceTBO == 0) {
+    std::cerr << "Failed to generate VBO/EBO/TBO" << std::endl;
     cleanup();
     return false;
   }
 
+  // Optional, rendering works without it
+  _pipelineStatistics.initialize();
+
+  // Optional, cluster culled rendering falls back to instanced rendering without it
+  _clusterCullingAvailable = _clusterCuller.initialize();
+
+  // Optional, the scene is lit without shadows when it fails
+  _shadowMap.initialize();
+
+  // Only the tessellated path draws patches, all of them triangles
+  glPatchParameteri(GL_PATCH_VERTICES, 3);
+
   return true;
 }
 
 void GeometryRenderer::cleanup() {
   if (_sphereVAO != 0) {
-    glDeleteVertexArrays(1, &_sphereVAO);
+    GLStateCache::deleteVertexArray(_sphereVAO);
     _sphereVAO = 0;
   }
+  if (_emptyVAO != 0) {
+    GLStateCache::deleteVertexArray(_emptyVAO);
+    _emptyVAO = 0;
+  }
   if (_sphereVBO != 0) {
-    glDeleteBuffers(1, &_sphereVBO);
+    GLStateCache::deleteBuffer(_sphereVBO);
     _sphereVBO = 0;
   }
   if (_sphereEBO != 0) {
-    glDeleteBuffers(1, &_sphereEBO);
+    GLStateCache::deleteBuffer(_sphereEBO);
     _sphereEBO = 0;
   }
-  if (_instanceSSBO != 0) {
-    glDeleteBuffers(1, &_instanceSSBO);
-    _instanceSSBO = 0;
-  }
-  if (_indirectBuffer != 0) {
-    glDeleteBuffers(1, &_indirectBuffer);
-    _indirectBuffer = 0;
+  if (_instanceTBO != 0) {
+    GLStateCache::deleteTexture(_instanceTBO);
+    _instanceTBO = 0;
   }
+  _pipelineStatistics.cleanup();
+  _clusterCuller.cleanup();
+  _clusterCullingAvailable = false;
+  _shadowMap.cleanup();
 }
 
 bool GeometryRenderer::setupSphereGeometry(float radius, int segments) {
+  PROFILE_ZONE("GeometryRenderer::setupSphereGeometry");
+
   if (_sphereVAO == 0) {
     std::cerr << "GeometryRenderer not initialized" << std::endl;
     return false;
   }
 
   // Generate sphere geometry
-  _sphereGeometry = Sphere::generateSphere(segments, radius);
+  _sphereGeometry = Sphere::generate(_sphereTopology, segments, radius);
+  _sphereRadius = radius;
+  _sphereSegments = segments;
+
+  // LOD chain: halve the segments per level, packed after LOD 0 in the same buffers
+  std::vector<Vertex> vertices = _sphereGeometry.vertices;
+  std::vector<GLuint> indices = _sphereGeometry.indices;
+  _sphereLods[0] = {segments, 0, static_cast<unsigned int>(_sphereGeometry.indexCount), 0};
+  _sphereLodCount = 1;
+  for (int lod = 1; lod < MAX_SPHERE_LODS; ++lod) {
+    int lodSegments = std::max(4, segments >> lod);
+    if (lodSegments >= _sphereLods[lod - 1].segments) {
+      break;
+    }
+    SphereGeometry lodGeometry = Sphere::generate(_sphereTopology, lodSegments, radius);
+    _sphereLods[lod] = {lodSegments, static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(lodGeometry.indexCount), static_cast<int>(vertices.size())};
+    vertices.insert(vertices.end(), lodGeometry.vertices.begin(), lodGeometry.vertices.end());
+    indices.insert(indices.end(), lodGeometry.indices.begin(), lodGeometry.indices.end());
+    _sphereLodCount++;
+  }
+
+  // Cached multidraw arrays describe the old LODs
+  for (MultiDrawArrays& arrays : _multiDrawArrays) {
+    arrays = MultiDrawArrays();
+  }
+
+  // Split every LOD into clusters, reordering its indices so each cluster is contiguous
+  _clusterCuller.buildClusters(vertices, indices, _sphereLods, _sphereLodCount);
 
   // Setup instanced VAO
-  glBindVertexArray(_sphereVAO);
+  GLStateCache::bindVertexArray(_sphereVAO);
 
-  // Upload vertex data
-  glBindBuffer(GL_ARRAY_BUFFER, _sphereVBO);
-  glBufferData(GL_ARRAY_BUFFER, _sphereGeometry.vertices.size() * sizeof(Vertex), _sphereGeometry.vertices.data(), GL_STATIC_DRAW);
+  // Upload vertex data in the selected format
+  std::vector<uint8_t> packedVertices = packVertices(vertices, _vertexFormat);
+  _vertexBufferBytes = packedVertices.size();
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, _sphereVBO);
+  glBufferData(GL_ARRAY_BUFFER, packedVertices.size(), packedVertices.data(), GL_STATIC_DRAW);
 
   // Upload index data
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphereEBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, _sphereGeometry.indices.size() * sizeof(GLuint), _sphereGeometry.indices.data(), GL_STATIC_DRAW);
+  GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphereEBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 
   // Setup vertex attributes
   _setupVertexAttributes();
 
-  glBindVertexArray(0);
+  GLStateCache::bindVertexArray(0);
 
   return true;
 }
 
 void GeometryRenderer::bindInstanceData(const InstanceManager& instanceManager) {
-  // Setup SSBO with instance data
-  _setupInstanceSSBO(instanceManager);
+  // All sources read the column buffers owned by the instance manager, nothing is copied here
+  const InstanceBufferHandle& instanceBuffer = instanceManager.getInstanceBuffer();
+  _bindInstanceColumns(instanceManager);
+  _setupInstanceAttributes(instanceBuffer);
+  _setupInstanceTexelBuffer(instanceBuffer);
 }
 
-void GeometryRenderer::_setupVertexAttributes() {
-  // Position (location 0)
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-  glEnableVertexAttribArray(0);
+void GeometryRenderer::setVertexFormat(VertexFormat format) {
+  if (format == _vertexFormat) {
+    return;
+  }
+  _vertexFormat = format;
+  if (_sphereSegments > 0) {
+    setupSphereGeometry(_sphereRadius, _sphereSegments);
+  }
+}
 
-  // Normal (location 1)
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
+void GeometryRenderer::setSphereTopology(SphereTopology topology) {
+  if (topology == _sphereTopology) {
+    return;
+  }
+  _sphereTopology = topology;
+  if (_sphereSegments > 0) {
+    setupSphereGeometry(_sphereRadius, _sphereSegments);
+  }
 }
 
-void GeometryRenderer::_setupInstanceSSBO(const InstanceManager& instanceManager) {
-  // Bind SSBO and upload instance matrices
-  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _instanceSSBO);
+void GeometryRenderer::_setupVertexAttributes() {
+  GLsizei stride = getVertexStride(_vertexFormat);
+  switch (_vertexFormat) {
+    case VertexFormat::SNORM16:
+      // Unit position (location 0), normalized to [-1, 1] by the fetch
+      glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+      glEnableVertexAttribArray(0);
+      glDisableVertexAttribArray(1);
+      break;
+    case VertexFormat::OCTAHEDRAL:
+      // Octahedral direction (location 0), normalized to [-1, 1] by the fetch
+      glVertexAttribPointer(0, 2, GL_SHORT, GL_TRUE, stride, (void*)0);
+      glEnableVertexAttribArray(0);
+      glDisableVertexAttribArray(1);
+      break;
+    default:
+      // Position (location 0)
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+      glEnableVertexAttribArray(0);
+
+      // Normal (location 1)
+      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+      glEnableVertexAttribArray(1);
+      break;
+  }
+}
 
-  const auto& matrices = instanceManager.getInstanceMatrices();
-  glBufferData(GL_SHADER_STORAGE_BUFFER, matrices.size() * sizeof(glm::mat4), matrices.data(), GL_DYNAMIC_DRAW);
+void GeometryRenderer::_bindInstanceColumns(const InstanceManager& instanceManager) {
+  // Every column at its own binding point, each program declares only the ones it reads
+  for (int i = 0; i < INSTANCE_ATTRIBUTE_COUNT; ++i) {
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_ATTRIBUTE_BINDINGS[i], instanceManager.getAttributeBuffer(static_cast<InstanceAttribute>(i)));
+  }
+}
+
+void GeometryRenderer::_setupInstanceAttributes(const InstanceBufferHandle& instanceBuffer) {
+  GLStateCache::bindVertexArray(_sphereVAO);
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer.buffer);
 
-  // Bind to binding point 0
-  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _instanceSSBO);
+  // Instance matrix (locations 2-5, one vec4 column each, advanced per instance)
+  for (GLuint column = 0; column < 4; ++column) {
+    GLuint location = 2 + column;
+    glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, instanceBuffer.stride, (void*)(column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
 
-  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  GLStateCache::bindVertexArray(0);
+  GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void GeometryRenderer::renderMultiDrawIndirect(const InstanceManager& instanceManager, const Camera& camera) {
-  int instanceCount = instanceManager.getCurrentInstanceCount();
-  if (instanceCount <= 0)
-    return;
+void GeometryRenderer::_setupInstanceTexelBuffer(const InstanceBufferHandle& instanceBuffer) {
+  // Re-attach after each upload, the buffer storage may have been reallocated
+  GLStateCache::bindTexture(0, GL_TEXTURE_BUFFER, _instanceTBO);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instanceBuffer.buffer);
+}
 
-  _setupIndirectBuffer(instanceManager);
+InstanceDataSource GeometryRenderer::_resolveInstanceDataSource(RenderMethod method) const {
+  return isInstanceDataSourceSupported(method, _instanceDataSource) ? _instanceDataSource : InstanceDataSource::SSBO;
+}
 
-  unsigned int shaderProgram = _shaderManager->getProgram(RenderMethod::INSTANCED);
-  glUseProgram(shaderProgram);
+void GeometryRenderer::_useProgram(RenderMethod method, const Camera& camera) {
+  InstanceDataSource source = _resolveInstanceDataSource(method);
+  _shaderManager->useProgram(method, source, _vertexFormat);
 
   // Set uniforms
   _shaderManager->setMatrix4("view", camera.getViewMatrix());
   _shaderManager->setMatrix4("projection", camera.getProjectionMatrix());
 
-  // Bind vertex array and SSBO
-  glBindVertexArray(_sphereVAO);
+  // Compressed formats store unit directions, scaled in the shader
+  if (_vertexFormat != VertexFormat::FLOAT32 && method != RenderMethod::VERTEX_PULLING) {
+    _shaderManager->setFloat("sphereRadius", _sphereRadius);
+  }
+
+  if (source == InstanceDataSource::TEXTURE_BUFFER) {
+    GLStateCache::bindTexture(0, GL_TEXTURE_BUFFER, _instanceTBO);
+    _shaderManager->setInt("instanceTexels", 0);
+  }
 
-  // Bind indirect buffer and execute multidraw indirect
-  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+  // Shadow lookups, the sampler keeps its own unit even when shadows are off
+  bool shadows = _shadowsEnabled && _shadowMap.isAvailable();
+  _shaderManager->setInt("shadowMap", SHADOW_TEXTURE_UNIT);
+  _shaderManager->setInt("shadowCascades", shadows ? _shadowMap.getCascadeCount() : 0);
+  if (shadows) {
+    GLStateCache::bindTexture(SHADOW_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, _shadowMap.getTexture());
+    _shaderManager->setMatrix4Array("shadowMatrices", _shadowMap.getCascadeMatrices(), _shadowMap.getCascadeCount());
+  }
+}
 
-  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 1, 0);
+void GeometryRenderer::renderShadows(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderShadows");
 
-  glBindVertexArray(0);
-  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  if (!_shadowsEnabled || !_shadowMap.isAvailable() || frame.totalCount == 0 || _sphereLodCount == 0)
+    return;
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  _shadowMap.update(camera, SHADOW_LIGHT_DIRECTION, SHADOW_DISTANCE);
+  if (!_shadowMap.begin(*_shaderManager, _vertexFormat, _sphereRadius))
+    return;
+
+  // Coarsest LOD is plenty for a depth silhouette, every instance once per cascade in one draw
+  const SphereLod& shadowLod = _sphereLods[_sphereLodCount - 1];
+  GLStateCache::bindVertexArray(_sphereVAO);
+  glDrawElementsInstancedBaseVertex(GL_TRIANGLES, shadowLod.indexCount, GL_UNSIGNED_INT, (void*)(shadowLod.firstIndex * sizeof(GLuint)),
+                                    frame.totalCount * _shadowMap.getCascadeCount(), shadowLod.baseVertex);
+
+  _shadowMap.end();
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 }
 
-void GeometryRenderer::renderInstanced(const InstanceManager& instanceManager, const Camera& camera) {
-  int instanceCount = instanceManager.getCurrentInstanceCount();
-  if (instanceCount <= 0)
+void GeometryRenderer::render(RenderMethod method, const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::render");
+
+  // Visible instance indices of this frame (binding 1)
+  GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, frame.indexBuffer);
+
+  _pipelineStatistics.begin(method);
+
+  switch (method) {
+    case RenderMethod::INSTANCED:
+      renderInstanced(frame, camera);
+      break;
+    case RenderMethod::MULTIDRAW:
+      renderMultiDraw(frame, camera);
+      break;
+    case RenderMethod::MULTIDRAW_INDIRECT:
+      renderMultiDrawIndirect(frame, camera);
+      break;
+    case RenderMethod::VERTEX_PULLING:
+      renderVertexPulling(frame, camera);
+      break;
+    case RenderMethod::CLUSTER_CULLING:
+      renderClusterCulled(frame, camera);
+      break;
+    case RenderMethod::TESSELLATION:
+      renderTessellated(frame, camera);
+      break;
+  }
+
+  _pipelineStatistics.end();
+}
+
+void GeometryRenderer::renderMultiDrawIndirect(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderMultiDrawIndirect");
+
+  if (frame.totalCount == 0)
     return;
 
-  unsigned int shaderProgram = _shaderManager->getProgram(RenderMethod::INSTANCED);
-  glUseProgram(shaderProgram);
+  _useProgram(RenderMethod::INSTANCED, camera);
 
-  // Set uniforms
-  _shaderManager->setMatrix4("view", camera.getViewMatrix());
-  _shaderManager->setMatrix4("projection", camera.getProjectionMatrix());
+  // Sphere mesh and this frame's commands; the instance buffers stay bound from bindInstanceData
+  GLStateCache::bindVertexArray(_sphereVAO);
+  GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, frame.indirectBuffer);
+
+  if (_resolveInstanceDataSource(RenderMethod::MULTIDRAW_INDIRECT) == InstanceDataSource::VERTEX_ATTRIBUTE) {
+    // Divisor attributes cannot follow the visible list, use the command drawing every instance
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(MAX_SPHERE_LODS * sizeof(DrawElementsIndirectCommand)), 1, 0);
+  } else {
+    // One command per LOD, baseInstance selects its range of the visible list
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, frame.lodCount, 0);
+  }
+}
 
-  // Bind vertex array and SSBO
-  glBindVertexArray(_sphereVAO);
+void GeometryRenderer::renderInstanced(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderInstanced");
 
-  // Render instances
-  glDrawElementsInstanced(GL_TRIANGLES, _sphereGeometry.indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+  if (frame.totalCount == 0)
+    return;
 
-  glBindVertexArray(0);
+  _useProgram(RenderMethod::INSTANCED, camera);
+
+  GLStateCache::bindVertexArray(_sphereVAO);
+
+  if (_resolveInstanceDataSource(RenderMethod::INSTANCED) == InstanceDataSource::VERTEX_ATTRIBUTE) {
+    // Divisor attributes cannot follow the visible list, draw every instance with LOD 0
+    glDrawElementsInstanced(GL_TRIANGLES, _sphereLods[0].indexCount, GL_UNSIGNED_INT, 0, frame.totalCount);
+  } else {
+    // One instanced draw per LOD
+    for (int lod = 0; lod < frame.lodCount; ++lod) {
+      const LodRange& range = frame.lodRanges[lod];
+      if (range.count == 0)
+        continue;
+      const SphereLod& sphereLod = _sphereLods[lod];
+      glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, sphereLod.indexCount, GL_UNSIGNED_INT, (void*)(sphereLod.firstIndex * sizeof(GLuint)), range.count,
+                                                    sphereLod.baseVertex, range.firstVisible);
+    }
+  }
 }
 
-void GeometryRenderer::renderMultiDraw(const InstanceManager& instanceManager, const Camera& camera) {
-  int instanceCount = instanceManager.getCurrentInstanceCount();
-  if (instanceCount <= 0)
+void GeometryRenderer::renderMultiDraw(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderMultiDraw");
+
+  if (frame.visibleCount == 0)
     return;
 
-  unsigned int shaderProgram = _shaderManager->getProgram(RenderMethod::MULTIDRAW);
-  glUseProgram(shaderProgram);
+  _useProgram(RenderMethod::MULTIDRAW, camera);
 
-  // Set uniforms
-  _shaderManager->setMatrix4("view", camera.getViewMatrix());
-  _shaderManager->setMatrix4("projection", camera.getProjectionMatrix());
+  GLStateCache::bindVertexArray(_sphereVAO);
+
+  // One draw per visible instance, one call per LOD; gl_DrawID restarts at each call
+  for (int lod = 0; lod < frame.lodCount; ++lod) {
+    const LodRange& range = frame.lodRanges[lod];
+    if (range.count == 0)
+      continue;
+    const MultiDrawArrays& arrays = _getMultiDrawArrays(lod, range.count);
+    _shaderManager->setInt("firstDraw", static_cast<int>(range.firstVisible));
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, arrays.counts.data(), GL_UNSIGNED_INT, const_cast<const void**>(arrays.offsets.data()), range.count,
+                                  const_cast<GLint*>(arrays.baseVertices.data()));
+  }
+}
+
+void GeometryRenderer::renderVertexPulling(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderVertexPulling");
+
+  if (frame.visibleCount == 0 || _sphereSegments < 2)
+    return;
 
-  // Bind vertex array and SSBO
-  glBindVertexArray(_sphereVAO);
+  _useProgram(RenderMethod::VERTEX_PULLING, camera);
+  _shaderManager->setFloat("sphereRadius", _sphereRadius);
 
-  // Create arrays for multidraw - each draw uses the same geometry but different matrix from SSBO
-  std::vector<GLsizei> counts(instanceCount, _sphereGeometry.indexCount);
-  std::vector<const void*> indices(instanceCount, 0);  // All use same index buffer
+  // Empty VAO: positions and normals are generated from gl_VertexID, always as a UV sphere whatever the topology
+  GLStateCache::bindVertexArray(_emptyVAO);
 
-  // Render all spheres in one multidraw call
-  glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, indices.data(), instanceCount);
+  for (int lod = 0; lod < frame.lodCount; ++lod) {
+    const LodRange& range = frame.lodRanges[lod];
+    if (range.count == 0)
+      continue;
 
-  glBindVertexArray(0);
+    // Two triangles per quad, (rings - 1) x (sectors - 1) quads
+    int rings = _sphereLods[lod].segments;
+    int sectors = rings * 2;
+    GLsizei vertexCount = (rings - 1) * (sectors - 1) * 6;
+
+    _shaderManager->setInt("sphereSegments", rings);
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, vertexCount, range.count, range.firstVisible);
+  }
 }
 
-void GeometryRenderer::_setupIndirectBuffer(const InstanceManager& instanceManager) {
-  int instanceCount = instanceManager.getCurrentInstanceCount();
+void GeometryRenderer::renderClusterCulled(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderClusterCulled");
 
-  // Create draw command structure for each instance
-  struct DrawElementsIndirectCommand {
-    GLuint count;          // Number of elements to draw
-    GLuint instanceCount;  // Number of instances (1 per command)
-    GLuint firstIndex;     // Offset into index buffer
-    GLuint baseVertex;     // Offset into vertex buffer
-    GLuint baseInstance;   // Base instance for gl_InstanceID
-  };
+  if (!_clusterCullingAvailable) {
+    renderInstanced(frame, camera);
+    return;
+  }
+
+  if (frame.visibleCount == 0)
+    return;
 
-  std::vector<DrawElementsIndirectCommand> commands(1);
+  // Compute passes fill per-cluster instance lists and one command per cluster
+  _clusterCuller.cull(frame, camera);
 
-  commands[0].count = static_cast<GLuint>(_sphereGeometry.indexCount);
-  commands[0].instanceCount = instanceCount;
-  commands[0].firstIndex = 0;
-  commands[0].baseVertex = 0;
-  commands[0].baseInstance = 0;
+  // The cluster instance lists replace the visible list, baseInstance selects a cluster's range
+  GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _clusterCuller.getInstanceBuffer());
+
+  _useProgram(RenderMethod::CLUSTER_CULLING, camera);
+
+  GLStateCache::bindVertexArray(_sphereVAO);
+  GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, _clusterCuller.getCommandBuffer());
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, _clusterCuller.getClusterCount(), 0);
+}
+
+void GeometryRenderer::renderTessellated(const PreparedFrame& frame, const Camera& camera) {
+  PROFILE_ZONE("GeometryRenderer::renderTessellated");
+
+  // Without a tessellation program the mesh LODs are drawn instead
+  if (_shaderManager->getProgram(RenderMethod::TESSELLATION) == 0) {
+    renderInstanced(frame, camera);
+    return;
+  }
+
+  if (frame.visibleCount == 0)
+    return;
+
+  _useProgram(RenderMethod::TESSELLATION, camera);
+  _shaderManager->setFloat("sphereRadius", _sphereRadius);
+  _shaderManager->setFloat("viewportHeight", frame.viewportHeight);
+  _shaderManager->setFloat("tessellationError", TESSELLATION_ERROR_PIXELS * std::exp2(frame.lodBias));
+
+  // Empty VAO: the octahedron corners are generated from gl_VertexID
+  GLStateCache::bindVertexArray(_emptyVAO);
+
+  // The LOD ranges are contiguous, so one draw covers every visible sphere in the list's order
+  glDrawArraysInstancedBaseInstance(GL_PATCHES, 0, OCTAHEDRON_PATCH_VERTICES, frame.visibleCount, 0);
+}
+
+const GeometryRenderer::MultiDrawArrays& GeometryRenderer::_getMultiDrawArrays(int lod, size_t drawCount) {
+  MultiDrawArrays& arrays = _multiDrawArrays[lod];
+  if (drawCount <= arrays.counts.size()) {
+    return arrays;
+  }
 
-  // Upload commands to indirect buffer
-  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
-  glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_DYNAMIC_DRAW);
-  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  // Grow geometrically so a rising visible count settles quickly
+  size_t size = std::max(drawCount, arrays.counts.size() * 2);
+  const SphereLod& sphereLod = _sphereLods[lod];
+  arrays.counts.assign(size, static_cast<GLsizei>(sphereLod.indexCount));
+  arrays.offsets.assign(size, reinterpret_cast<const void*>(sphereLod.firstIndex * sizeof(GLuint)));
+  arrays.baseVertices.assign(size, sphereLod.baseVertex);
+  return arrays;
 }
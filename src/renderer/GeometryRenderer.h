@@ -1,14 +1,23 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 #include <GL/glew.h>
 #include "../geo/Sphere.h"
+#include "ClusterCuller.h"
+#include "InstanceDataSource.h"
+#include "PipelineStatistics.h"
 #include "RenderMethod.h"
+#include "ShadowMap.h"
+#include "SphereLod.h"
+#include "VertexFormat.h"
 
 // Forward declarations
 class InstanceManager;
+struct InstanceBufferHandle;
 class Camera;
 class ShaderManager;
+struct PreparedFrame;
 
 class GeometryRenderer {
 public:
@@ -23,10 +32,24 @@ public:
   bool setupSphereGeometry(float radius, int segments);
   void bindInstanceData(const InstanceManager& instanceManager);
 
-  // Rendering methods
-  void renderInstanced(const InstanceManager& instanceManager, const Camera& camera);
-  void renderMultiDraw(const InstanceManager& instanceManager, const Camera& camera);
-  void renderMultiDrawIndirect(const InstanceManager& instanceManager, const Camera& camera);
+  // Rendering methods, drawing the visible instances of a prepared frame
+  void render(RenderMethod method, const PreparedFrame& frame, const Camera& camera);
+  void renderInstanced(const PreparedFrame& frame, const Camera& camera);
+  void renderMultiDraw(const PreparedFrame& frame, const Camera& camera);
+  void renderMultiDrawIndirect(const PreparedFrame& frame, const Camera& camera);
+  void renderVertexPulling(const PreparedFrame& frame, const Camera& camera);
+  void renderClusterCulled(const PreparedFrame& frame, const Camera& camera);
+  // Octahedron per sphere refined on the GPU by its projected size, ignores the mesh LODs
+  void renderTessellated(const PreparedFrame& frame, const Camera& camera);
+
+  // Cascaded shadow pass over every instance, before the main pass; its result is sampled while shadows are enabled
+  void renderShadows(const PreparedFrame& frame, const Camera& camera);
+  void setShadowsEnabled(bool enabled) {
+    _shadowsEnabled = enabled;
+  }
+  bool areShadowsAvailable() const {
+    return _shadowMap.isAvailable();
+  }
 
   // Set shader manager reference
   void setShaderManager(ShaderManager* shaderManager) {
@@ -37,6 +60,44 @@ public:
   const SphereGeometry& getSphereGeometry() const {
     return _sphereGeometry;
   }
+  const SphereLod* getSphereLods() const {
+    return _sphereLods;
+  }
+  int getSphereLodCount() const {
+    return _sphereLodCount;
+  }
+  float getSphereRadius() const {
+    return _sphereRadius;
+  }
+  const ClusterCuller& getClusterCuller() const {
+    return _clusterCuller;
+  }
+  const PipelineStatistics& getPipelineStatistics() const {
+    return _pipelineStatistics;
+  }
+
+  // Where the shaders read instance matrices from (unsupported combinations use the SSBO)
+  void setInstanceDataSource(InstanceDataSource source) {
+    _instanceDataSource = source;
+  }
+  InstanceDataSource getInstanceDataSource() const {
+    return _instanceDataSource;
+  }
+
+  // Sphere vertex layout, the VBO is rebuilt when it changes
+  void setVertexFormat(VertexFormat format);
+  VertexFormat getVertexFormat() const {
+    return _vertexFormat;
+  }
+  size_t getVertexBufferBytes() const {
+    return _vertexBufferBytes;
+  }
+
+  // Triangulation of the sphere at the silhouette error of its segments, the buffers are rebuilt when it changes
+  void setSphereTopology(SphereTopology topology);
+  SphereTopology getSphereTopology() const {
+    return _sphereTopology;
+  }
 
   // Render method (placeholder for compatibility)
   void setRenderMethod(RenderMethod method) {
@@ -44,21 +105,54 @@ public:
   }
 
 private:
-  // Sphere geometry data
+  // Sphere geometry data (LOD 0), all LODs share the VBO/EBO
   SphereGeometry _sphereGeometry;
+  SphereLod _sphereLods[MAX_SPHERE_LODS];
+  int _sphereLodCount;
+  float _sphereRadius;
+  int _sphereSegments;
+  SphereTopology _sphereTopology;
 
   // OpenGL objects
   GLuint _sphereVAO;
+  GLuint _emptyVAO;  // Attribute-less VAO for vertex pulling
   GLuint _sphereVBO;
   GLuint _sphereEBO;
-  GLuint _instanceSSBO;    // SSBO for instance matrices
-  GLuint _indirectBuffer;  // Buffer for indirect draw commands
+  GLuint _instanceTBO;  // Texture buffer over the instance buffer
+
+  InstanceDataSource _instanceDataSource;
+  VertexFormat _vertexFormat;
+  size_t _vertexBufferBytes;
+
+  // Per-method GPU counters
+  PipelineStatistics _pipelineStatistics;
+
+  // Sphere clusters and their per-instance culling passes
+  ClusterCuller _clusterCuller;
+  bool _clusterCullingAvailable;
+
+  // glMultiDrawElementsBaseVertex arrays per LOD; every entry of a LOD is the same, so they only grow
+  // with the visible count and are rebuilt when the geometry changes
+  struct MultiDrawArrays {
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+  };
+  MultiDrawArrays _multiDrawArrays[MAX_SPHERE_LODS];
+
+  // Directional light shadows, optional
+  ShadowMap _shadowMap;
+  bool _shadowsEnabled;
 
   // Reference to shader manager
   ShaderManager* _shaderManager = nullptr;
 
   // Helper methods
   void _setupVertexAttributes();
-  void _setupInstanceSSBO(const InstanceManager& instanceManager);
-  void _setupIndirectBuffer(const InstanceManager& instanceManager);
+  void _bindInstanceColumns(const InstanceManager& instanceManager);
+  void _setupInstanceAttributes(const InstanceBufferHandle& instanceBuffer);
+  void _setupInstanceTexelBuffer(const InstanceBufferHandle& instanceBuffer);
+  InstanceDataSource _resolveInstanceDataSource(RenderMethod method) const;
+  void _useProgram(RenderMethod method, const Camera& camera);
+  const MultiDrawArrays& _getMultiDrawArrays(int lod, size_t drawCount);
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "GpuBuffer.h"
+
+#include <algorithm>
+#include <GL/glew.h>
+#include "GLStateCache.h"
+#include "../utils/Profiler.h"
+
+size_t GpuBuffer::_totalCapacity = 0;
+size_t GpuBuffer::_peakTotalCapacity = 0;
+unsigned int GpuBuffer::_totalAllocationCount = 0;
+
+GpuBuffer::GpuBuffer(unsigned int storageFlags)
+    : _storageFlags(storageFlags), _buffer(0), _size(0), _capacity(0), _allocationCount(0), _underusedUploads(0), _immutable(false) {}
+
+GpuBuffer::~GpuBuffer() {
+  cleanup();
+}
+
+void GpuBuffer::cleanup() {
+  if (_buffer != 0) {
+    GLStateCache::deleteBuffer(_buffer);
+    _buffer = 0;
+  }
+  _totalCapacity -= _capacity;
+  _capacity = 0;
+  _size = 0;
+  _underusedUploads = 0;
+}
+
+void GpuBuffer::reserve(size_t sizeBytes) {
+  _size = sizeBytes;
+
+  if (sizeBytes > _capacity) {
+    _underusedUploads = 0;
+    _allocate(std::max({sizeBytes, _capacity * 2, MIN_CAPACITY}));
+    return;
+  }
+
+  // Shrink only after the size has stayed small for a while, so oscillating counts do not thrash
+  if (sizeBytes * 4 <= _capacity && _capacity > MIN_CAPACITY) {
+    if (++_underusedUploads >= SHRINK_AFTER_UPLOADS) {
+      _underusedUploads = 0;
+      _allocate(std::max(sizeBytes * 2, MIN_CAPACITY));
+    }
+  } else {
+    _underusedUploads = 0;
+  }
+}
+
+void GpuBuffer::upload(const void* data, size_t sizeBytes) {
+  reserve(sizeBytes);
+  if (sizeBytes == 0) {
+    return;
+  }
+
+  GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeBytes, data);
+}
+
+void GpuBuffer::write(size_t offset, const void* data, size_t sizeBytes) {
+  if (sizeBytes == 0 || offset + sizeBytes > _size) {
+    return;
+  }
+
+  GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, offset, sizeBytes, data);
+}
+
+void GpuBuffer::_allocate(size_t capacity) {
+  PROFILE_ZONE("GpuBuffer::allocate");
+
+  _immutable = GLEW_ARB_buffer_storage || GLEW_VERSION_4_4;
+
+  // Immutable storage cannot be resized, it takes a new buffer object
+  if (_buffer != 0 && _immutable) {
+    GLStateCache::deleteBuffer(_buffer);
+    _buffer = 0;
+  }
+  if (_buffer == 0) {
+    glGenBuffers(1, &_buffer);
+  }
+
+  GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+  if (_immutable) {
+    glBufferStorage(GL_COPY_WRITE_BUFFER, capacity, nullptr, _storageFlags);
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+  }
+  GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  _totalCapacity = _totalCapacity - _capacity + capacity;
+  _peakTotalCapacity = std::max(_peakTotalCapacity, _totalCapacity);
+  _capacity = capacity;
+  _allocationCount++;
+  _totalAllocationCount++;
+}
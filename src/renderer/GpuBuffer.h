@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// GL buffer with geometric capacity growth, so resizes within capacity are sub-range writes.
+// With ARB_buffer_storage (core in 4.4) the storage is immutable and growing creates a new buffer
+// object, callers re-bind after any call that may reallocate. The buffer shrinks lazily, once
+// uploads have used less than a quarter of the capacity several times in a row.
+class GpuBuffer {
+public:
+  // storageFlags apply to immutable storage, e.g. GL_DYNAMIC_STORAGE_BIT for glBufferSubData updates
+  explicit GpuBuffer(unsigned int storageFlags);
+  ~GpuBuffer();
+
+  GpuBuffer(const GpuBuffer&) = delete;
+  GpuBuffer& operator=(const GpuBuffer&) = delete;
+
+  void cleanup();
+
+  // Ensures room for at least sizeBytes, contents are not preserved when it reallocates
+  void reserve(size_t sizeBytes);
+
+  // Reserves and writes data at the start of the buffer
+  void upload(const void* data, size_t sizeBytes);
+
+  // Writes data at offset, which with sizeBytes must lie within the reserved size
+  void write(size_t offset, const void* data, size_t sizeBytes);
+
+  unsigned int getBuffer() const {
+    return _buffer;
+  }
+  size_t getSize() const {
+    return _size;
+  }
+  size_t getCapacity() const {
+    return _capacity;
+  }
+  unsigned int getAllocationCount() const {
+    return _allocationCount;
+  }
+  bool isImmutable() const {
+    return _immutable;
+  }
+
+  // Totals over every GpuBuffer, for memory reporting
+  static size_t getTotalCapacity() {
+    return _totalCapacity;
+  }
+  static size_t getPeakTotalCapacity() {
+    return _peakTotalCapacity;
+  }
+  static unsigned int getTotalAllocationCount() {
+    return _totalAllocationCount;
+  }
+
+private:
+  static constexpr size_t MIN_CAPACITY = 4096;
+  static constexpr int SHRINK_AFTER_UPLOADS = 8;
+
+  unsigned int _storageFlags;
+  unsigned int _buffer;
+  size_t _size;
+  size_t _capacity;
+  unsigned int _allocationCount;
+  int _underusedUploads;
+  bool _immutable;
+
+  static size_t _totalCapacity;
+  static size_t _peakTotalCapacity;
+  static unsigned int _totalAllocationCount;
+
+  // Helper methods
+  void _allocate(size_t capacity);
+};
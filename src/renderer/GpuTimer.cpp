@@ -0,0 +1,66 @@
+#include "GpuTimer.h"
+
+#include <GL/glew.h>
+
+GpuTimer::GpuTimer() : _queries{}, _pending{}, _current(0), _active(false), _initialized(false), _hasResult(false), _lastMs(0.0) {}
+
+GpuTimer::~GpuTimer() {
+  cleanup();
+}
+
+bool GpuTimer::initialize() {
+  // Timer queries are core since GL 3.3
+  glGenQueries(FRAME_LATENCY, _queries);
+  for (bool& pending : _pending) {
+    pending = false;
+  }
+  _initialized = true;
+  return true;
+}
+
+void GpuTimer::cleanup() {
+  if (!_initialized) {
+    return;
+  }
+  glDeleteQueries(FRAME_LATENCY, _queries);
+  _initialized = false;
+}
+
+void GpuTimer::begin() {
+  if (!_initialized || _active) {
+    return;
+  }
+
+  // Reuse the oldest query, harvesting it first if the GPU is done with it
+  if (_pending[_current]) {
+    _collect(_current);
+  }
+  glBeginQuery(GL_TIME_ELAPSED, _queries[_current]);
+  _active = true;
+}
+
+void GpuTimer::end() {
+  if (!_initialized || !_active) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  _pending[_current] = true;
+  _current = (_current + 1) % FRAME_LATENCY;
+  _active = false;
+}
+
+void GpuTimer::_collect(int index) {
+  _pending[index] = false;
+
+  // Drop the sample rather than stall when the GPU is still behind
+  GLuint available = 0;
+  glGetQueryObjectuiv(_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return;
+  }
+
+  GLuint64 elapsedNs = 0;
+  glGetQueryObjectui64v(_queries[index], GL_QUERY_RESULT, &elapsedNs);
+  _lastMs = elapsedNs / 1.0e6;
+  _hasResult = true;
+}
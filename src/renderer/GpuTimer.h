@@ -0,0 +1,37 @@
+#pragma once
+
+// GL_TIME_ELAPSED timer around a span of GL commands. Like PipelineStatistics, results are
+// read back a few frames late and dropped rather than waited for, so the CPU never stalls.
+class GpuTimer {
+public:
+  GpuTimer();
+  ~GpuTimer();
+
+  bool initialize();
+  void cleanup();
+
+  void begin();
+  void end();
+
+  // Latest completed measurement, in milliseconds
+  bool hasResult() const {
+    return _hasResult;
+  }
+  double getLastMs() const {
+    return _lastMs;
+  }
+
+private:
+  static const int FRAME_LATENCY = 3;
+
+  unsigned int _queries[FRAME_LATENCY];
+  bool _pending[FRAME_LATENCY];
+  int _current;
+  bool _active;
+  bool _initialized;
+  bool _hasResult;
+  double _lastMs;
+
+  // Helper methods
+  void _collect(int index);
+};
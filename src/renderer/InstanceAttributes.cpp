@@ -0,0 +1,61 @@
+#include "InstanceAttributes.h"
+#include <algorithm>
+#include "../utils/Profiler.h"
+
+void InstanceAttributeStore::resize(size_t count) {
+  size_t previousCount = _count;
+  _count = count;
+  for (int i = 0; i < INSTANCE_ATTRIBUTE_COUNT; ++i) {
+    markDirty(static_cast<InstanceAttribute>(i), previousCount, count);
+  }
+
+  _resizeColumns(InstanceAttributeIndices());
+
+  // Nothing past the end is left to upload
+  for (DirtyRange& range : _dirty) {
+    range.end = std::min(range.end, count);
+  }
+}
+
+void InstanceAttributeStore::clear() {
+  *this = InstanceAttributeStore();
+}
+
+const void* InstanceAttributeStore::getData(InstanceAttribute attribute) const {
+  int index = static_cast<int>(attribute);
+  return index >= 0 && index < INSTANCE_ATTRIBUTE_COUNT ? _getData(attribute, InstanceAttributeIndices()) : nullptr;
+}
+
+void InstanceAttributeStore::markDirty(InstanceAttribute attribute, size_t begin, size_t end) {
+  end = std::min(end, _count);
+  if (begin >= end) {
+    return;
+  }
+  DirtyRange& range = _dirty[static_cast<int>(attribute)];
+  if (range.empty()) {
+    range.begin = begin;
+    range.end = end;
+  } else {
+    range.begin = std::min(range.begin, begin);
+    range.end = std::max(range.end, end);
+  }
+}
+
+void InstanceAttributeStore::markAllDirty() {
+  for (int i = 0; i < INSTANCE_ATTRIBUTE_COUNT; ++i) {
+    markDirty(static_cast<InstanceAttribute>(i), 0, _count);
+  }
+}
+
+void InstanceAttributeStore::updateBounds(size_t begin, size_t end) {
+  PROFILE_ZONE("InstanceAttributeStore::updateBounds");
+
+  end = std::min(end, _count);
+  const glm::mat4* matrices = get<InstanceAttribute::MATRIX>();
+  glm::vec4* bounds = getMutable<InstanceAttribute::BOUNDS>();
+  for (size_t i = begin; i < end; ++i) {
+    const glm::mat4& model = matrices[i];
+    bounds[i] = glm::vec4(glm::vec3(model[3]), glm::length(glm::vec3(model[0])));
+  }
+  markDirty(InstanceAttribute::BOUNDS, begin, end);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Per-instance attributes, each stored as its own column
+enum class InstanceAttribute {
+  MATRIX = 0,  // Model matrix
+  BOUNDS = 1   // World-space center in xyz, scale of the unit sphere in w
+};
+
+const char* const INSTANCE_ATTRIBUTE_NAMES[] = {"Matrix", "Bounds"};
+
+// Also the number of columns; adding one takes an enum value, a name, a binding and a traits specialization
+constexpr int INSTANCE_ATTRIBUTE_COUNT = sizeof(INSTANCE_ATTRIBUTE_NAMES) / sizeof(INSTANCE_ATTRIBUTE_NAMES[0]);
+
+// Shader storage binding of each column's GPU mirror; 1-5 are taken by the visible list and the cluster culler
+const unsigned int INSTANCE_ATTRIBUTE_BINDINGS[] = {0, 6};
+
+template <InstanceAttribute A>
+struct InstanceAttributeTraits;
+
+template <>
+struct InstanceAttributeTraits<InstanceAttribute::MATRIX> {
+  using Type = glm::mat4;
+};
+
+template <>
+struct InstanceAttributeTraits<InstanceAttribute::BOUNDS> {
+  using Type = glm::vec4;
+};
+
+template <InstanceAttribute A>
+using InstanceAttributeType = typename InstanceAttributeTraits<A>::Type;
+
+// Columns are copied to the GPU as they are, so every element size must be its std430 array stride:
+// 4 or 8 bytes for scalars and 2-component vectors, a multiple of 16 otherwise (no vec3)
+constexpr bool isStd430ArrayStride(size_t size) {
+  return size == 4 || size == 8 || size % 16 == 0;
+}
+
+// One std::vector per attribute in InstanceAttribute order, with the element sizes, both from the traits
+template <typename Sequence>
+struct InstanceAttributeLayout;
+
+template <size_t... I>
+struct InstanceAttributeLayout<std::index_sequence<I...>> {
+  using Columns = std::tuple<std::vector<InstanceAttributeType<static_cast<InstanceAttribute>(I)>>...>;
+  static constexpr size_t STRIDES[] = {sizeof(InstanceAttributeType<static_cast<InstanceAttribute>(I)>)...};
+  static constexpr bool STD430 = (isStd430ArrayStride(sizeof(InstanceAttributeType<static_cast<InstanceAttribute>(I)>)) && ...);
+};
+
+using InstanceAttributeIndices = std::make_index_sequence<INSTANCE_ATTRIBUTE_COUNT>;
+
+static_assert(sizeof(INSTANCE_ATTRIBUTE_BINDINGS) / sizeof(INSTANCE_ATTRIBUTE_BINDINGS[0]) == INSTANCE_ATTRIBUTE_COUNT, "one binding per attribute");
+static_assert(InstanceAttributeLayout<InstanceAttributeIndices>::STD430, "column element size is not a std430 array stride");
+
+// Bytes per element of each column
+inline constexpr const size_t (&INSTANCE_ATTRIBUTE_STRIDES)[INSTANCE_ATTRIBUTE_COUNT] = InstanceAttributeLayout<InstanceAttributeIndices>::STRIDES;
+
+// Half-open range of elements written since the column was last uploaded
+struct DirtyRange {
+  size_t begin = 0;
+  size_t end = 0;
+
+  bool empty() const {
+    return begin >= end;
+  }
+};
+
+// Structure-of-arrays instance data: one tightly packed column per attribute, so a CPU kernel
+// streams only the columns it reads and each column has its own GPU mirror. Writers mark what
+// they changed, per column, and the uploader sends just those ranges.
+// A column can borrow memory owned by the caller (a mapped scene snapshot) instead of holding a copy.
+class InstanceAttributeStore {
+public:
+  // Resizes every owned column; new elements are value-initialized and marked dirty
+  void resize(size_t count);
+  void clear();
+  size_t size() const {
+    return _count;
+  }
+
+  // Owned storage of the column, released from any borrowed memory without copying it
+  template <InstanceAttribute A>
+  InstanceAttributeType<A>* getMutable() {
+    auto& column = std::get<static_cast<size_t>(A)>(_columns);
+    _borrowed[static_cast<int>(A)] = nullptr;
+    column.resize(_count);
+    return column.data();
+  }
+
+  template <InstanceAttribute A>
+  const InstanceAttributeType<A>* get() const {
+    const void* borrowed = _borrowed[static_cast<int>(A)];
+    return borrowed ? static_cast<const InstanceAttributeType<A>*>(borrowed) : std::get<static_cast<size_t>(A)>(_columns).data();
+  }
+
+  // Reads the column from data, which holds count elements and must stay valid until the column is
+  // written again. Growing the store past count copies the column into owned storage first.
+  template <InstanceAttribute A>
+  void borrow(const InstanceAttributeType<A>* data, size_t count) {
+    auto& column = std::get<static_cast<size_t>(A)>(_columns);
+    column.clear();
+    column.shrink_to_fit();
+    _borrowed[static_cast<int>(A)] = data;
+    _borrowedCount[static_cast<int>(A)] = count;
+  }
+
+  // Untyped column data, INSTANCE_ATTRIBUTE_STRIDES bytes per element
+  const void* getData(InstanceAttribute attribute) const;
+
+  // Dirty tracking, ranges merge into the smallest range covering both
+  void markDirty(InstanceAttribute attribute, size_t begin, size_t end);
+  void markAllDirty();
+  const DirtyRange& getDirtyRange(InstanceAttribute attribute) const {
+    return _dirty[static_cast<int>(attribute)];
+  }
+  void clearDirty(InstanceAttribute attribute) {
+    _dirty[static_cast<int>(attribute)] = DirtyRange();
+  }
+
+  // Derives the bounds of [begin, end) from the matrix column and marks them dirty
+  void updateBounds(size_t begin, size_t end);
+
+private:
+  InstanceAttributeLayout<InstanceAttributeIndices>::Columns _columns;
+  const void* _borrowed[INSTANCE_ATTRIBUTE_COUNT] = {};
+  size_t _borrowedCount[INSTANCE_ATTRIBUTE_COUNT] = {};
+  DirtyRange _dirty[INSTANCE_ATTRIBUTE_COUNT];
+  size_t _count = 0;
+
+  template <size_t... I>
+  void _resizeColumns(std::index_sequence<I...>) {
+    (_resizeColumn<static_cast<InstanceAttribute>(I)>(), ...);
+  }
+
+  // Owned columns follow the size, borrowed ones are taken over once the size outgrows them
+  template <InstanceAttribute A>
+  void _resizeColumn() {
+    auto& column = std::get<static_cast<size_t>(A)>(_columns);
+    const auto* borrowed = static_cast<const InstanceAttributeType<A>*>(_borrowed[static_cast<int>(A)]);
+    if (!borrowed) {
+      column.resize(_count);
+    } else if (_count > _borrowedCount[static_cast<int>(A)]) {
+      column.assign(borrowed, borrowed + _borrowedCount[static_cast<int>(A)]);
+      column.resize(_count);
+      _borrowed[static_cast<int>(A)] = nullptr;
+    }
+  }
+
+  template <size_t... I>
+  const void* _getData(InstanceAttribute attribute, std::index_sequence<I...>) const {
+    const void* columns[] = {static_cast<const void*>(get<static_cast<InstanceAttribute>(I)>())...};
+    return columns[static_cast<int>(attribute)];
+  }
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "RenderMethod.h"
+
+enum class InstanceDataSource { SSBO = 0, VERTEX_ATTRIBUTE = 1, TEXTURE_BUFFER = 2 };
+
+const char* const INSTANCE_DATA_SOURCE_NAMES[] = {"Shader Storage Buffer", "Vertex Attribute Divisor", "Texture Buffer Fetch"};
+
+// Not every render method can read every source:
+// - MULTIDRAW issues one single-instance draw per sphere, so a divisor attribute would always read matrix 0
+// - VERTEX_PULLING and TESSELLATION only have an SSBO variant
+// - CLUSTER_CULLING draws per-cluster instance lists, which a divisor attribute cannot follow
+constexpr bool isInstanceDataSourceSupported(RenderMethod method, InstanceDataSource source) {
+  switch (method) {
+    case RenderMethod::MULTIDRAW:
+    case RenderMethod::CLUSTER_CULLING:
+      return source != InstanceDataSource::VERTEX_ATTRIBUTE;
+    case RenderMethod::VERTEX_PULLING:
+    case RenderMethod::TESSELLATION:
+      return source == InstanceDataSource::SSBO;
+    default:
+      return true;
+  }
+}
@@ -0,0 +1,36 @@
+#include "InstanceGrid.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../utils/Profiler.h"
+
+void generateGridMatrices(int count, float spacing, std::vector<glm::mat4>& matrices) {
+  matrices.resize(count);
+  generateGridMatrices(count, spacing, matrices.data());
+}
+
+void generateGridMatrices(int count, float spacing, glm::mat4* matrices) {
+  PROFILE_ZONE("generateGridMatrices");
+
+  // Calculate grid size based on the instance count
+  int gridSize = static_cast<int>(std::sqrt(count));
+  if (gridSize * gridSize < count) {
+    gridSize++; // Ensure we have enough grid cells
+  }
+
+  float offset = (gridSize - 1) * spacing * 0.5f;
+
+  for (int i = 0; i < count; ++i) {
+    int x = i % gridSize;
+    int z = i / gridSize;
+
+    glm::mat4 model = glm::mat4(1.0f);
+
+    // Position in grid
+    float posX = x * spacing - offset;
+    float posZ = z * spacing - offset;
+    float posY = 0.0f;
+
+    model = glm::translate(model, glm::vec3(posX, posY, posZ));
+    matrices[i] = model;
+  }
+}
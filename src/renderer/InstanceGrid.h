@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// Model matrices of count instances on a square grid in the XZ plane, centered on the origin.
+// Replaces the contents of matrices, reusing its capacity. Plain CPU code, usable without a GL context.
+void generateGridMatrices(int count, float spacing, std::vector<glm::mat4>& matrices);
+
+// Same grid written to matrices[0, count), which must have room for count matrices
+void generateGridMatrices(int count, float spacing, glm::mat4* matrices);
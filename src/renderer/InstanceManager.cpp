@@ -1,25 +1,23 @@
 #include "InstanceManager.h"
 #include <GL/glew.h>
-#include <cmath>
-#include <glm/gtc/matrix_transform.hpp>
+#include "InstanceGrid.h"
+#include "../utils/Profiler.h"
 
 InstanceManager::InstanceManager()
-    : _instanceVBO(0), _currentInstanceCount(10000), _maxInstanceCount(100000),
-      _gridSpacing(0.1f) {}
+    : _columnBuffers{GpuBuffer(GL_DYNAMIC_STORAGE_BIT), GpuBuffer(GL_DYNAMIC_STORAGE_BIT)}, _currentInstanceCount(10000), _maxInstanceCount(100000),
+      _gridSpacing(0.1f), _uploadedBytes(0), _uploadCount(0) {}
 
 InstanceManager::~InstanceManager() { cleanup(); }
 
 bool InstanceManager::initialize(int maxInstances) {
   _maxInstanceCount = maxInstances;
 
-  // Generate instance buffer
-  glGenBuffers(1, &_instanceVBO);
-  if (_instanceVBO == 0) {
-    return false;
-  }
+  // Allocate the instance buffer shared by all render paths
+  _instanceBuffer.stride = INSTANCE_ATTRIBUTE_STRIDES[static_cast<int>(InstanceAttribute::MATRIX)];
+  _instanceBuffer.format = InstanceBufferFormat::MAT4_FLOAT32;
 
   updateInstanceData();
-  return true;
+  return _instanceBuffer.buffer != 0;
 }
 
 void InstanceManager::setInstanceCount(int count) {
@@ -29,47 +27,93 @@ void InstanceManager::setInstanceCount(int count) {
 }
 
 void InstanceManager::updateInstanceData() {
-  _generateGridPositions();
+  PROFILE_ZONE("InstanceManager::updateInstanceData");
 
-  // Update GPU buffer
-  glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
-  glBufferData(GL_ARRAY_BUFFER, _instanceMatrices.size() * sizeof(glm::mat4),
-               _instanceMatrices.data(), GL_DYNAMIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  _attributes.resize(_currentInstanceCount);
+  _generateGridPositions();
+  _attributes.markDirty(InstanceAttribute::MATRIX, 0, _attributes.size());
+  _attributes.updateBounds(0, _attributes.size());
+  _uploadDirtyColumns();
 }
 
-void InstanceManager::cleanup() {
-  if (_instanceVBO != 0) {
-    glDeleteBuffers(1, &_instanceVBO);
-    _instanceVBO = 0;
-  }
-  _instanceMatrices.clear();
-}
+void InstanceManager::setInstanceData(const glm::mat4* matrices, int count) {
+  PROFILE_ZONE("InstanceManager::setInstanceData");
 
-void InstanceManager::_generateGridPositions() {
-  _instanceMatrices.clear();
-  _instanceMatrices.reserve(_currentInstanceCount);
+  // No CPU copy of the matrices, the driver reads them from the caller's memory
+  _currentInstanceCount = count;
+  _attributes.borrow<InstanceAttribute::MATRIX>(matrices, count);
+  _attributes.resize(count);
+  _attributes.markDirty(InstanceAttribute::MATRIX, 0, _attributes.size());
+  _attributes.updateBounds(0, _attributes.size());
+  _uploadDirtyColumns();
+}
 
-  // Calculate grid size based on current instance count
-  int gridSize = static_cast<int>(std::sqrt(_currentInstanceCount));
-  if (gridSize * gridSize < _currentInstanceCount) {
-    gridSize++; // Ensure we have enough grid cells
+void InstanceManager::_uploadDirtyColumns() {
+  size_t count = _attributes.size();
+  for (int i = 0; i < INSTANCE_ATTRIBUTE_COUNT; ++i) {
+    InstanceAttribute attribute = static_cast<InstanceAttribute>(i);
+    GpuBuffer& buffer = _columnBuffers[i];
+    size_t stride = INSTANCE_ATTRIBUTE_STRIDES[i];
+
+    // A reallocated buffer starts out empty, so the whole column goes up again
+    DirtyRange range = _attributes.getDirtyRange(attribute);
+    unsigned int allocationCount = buffer.getAllocationCount();
+    buffer.reserve(count * stride);
+    if (buffer.getAllocationCount() != allocationCount) {
+      range.begin = 0;
+      range.end = count;
+    }
+    _attributes.clearDirty(attribute);
+    if (range.empty()) {
+      continue;
+    }
+
+    // Only the written elements, the rest of the column is already on the GPU
+    size_t sizeBytes = (range.end - range.begin) * stride;
+    buffer.write(range.begin * stride, static_cast<const char*>(_attributes.getData(attribute)) + range.begin * stride, sizeBytes);
+    _uploadedBytes += sizeBytes;
+    _uploadCount++;
   }
 
-  float offset = (gridSize - 1) * _gridSpacing * 0.5f;
+  const GpuBuffer& matrixBuffer = _columnBuffers[static_cast<int>(InstanceAttribute::MATRIX)];
+  _instanceBuffer.buffer = matrixBuffer.getBuffer();
+  _instanceBuffer.sizeBytes = matrixBuffer.getSize();
+  _instanceBuffer.capacityBytes = matrixBuffer.getCapacity();
+  _instanceBuffer.count = static_cast<int>(count);
+}
 
-  for (int i = 0; i < _currentInstanceCount; ++i) {
-    int x = i % gridSize;
-    int z = i / gridSize;
+size_t InstanceManager::getAttributeSizeBytes() const {
+  size_t sizeBytes = 0;
+  for (const GpuBuffer& buffer : _columnBuffers) {
+    sizeBytes += buffer.getSize();
+  }
+  return sizeBytes;
+}
 
-    glm::mat4 model = glm::mat4(1.0f);
+size_t InstanceManager::getAttributeCapacityBytes() const {
+  size_t capacityBytes = 0;
+  for (const GpuBuffer& buffer : _columnBuffers) {
+    capacityBytes += buffer.getCapacity();
+  }
+  return capacityBytes;
+}
 
-    // Position in grid
-    float posX = x * _gridSpacing - offset;
-    float posZ = z * _gridSpacing - offset;
-    float posY = 0.0f;
+unsigned int InstanceManager::getAllocationCount() const {
+  unsigned int allocationCount = 0;
+  for (const GpuBuffer& buffer : _columnBuffers) {
+    allocationCount += buffer.getAllocationCount();
+  }
+  return allocationCount;
+}
 
-    model = glm::translate(model, glm::vec3(posX, posY, posZ));
-    _instanceMatrices.push_back(model);
+void InstanceManager::cleanup() {
+  for (GpuBuffer& buffer : _columnBuffers) {
+    buffer.cleanup();
   }
-}
\ No newline at end of file
+  _instanceBuffer = InstanceBufferHandle();
+  _attributes.clear();
+}
+
+void InstanceManager::_generateGridPositions() {
+  generateGridMatrices(_currentInstanceCount, _gridSpacing, _attributes.getMutable<InstanceAttribute::MATRIX>());
+}
@@ -1,7 +1,27 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
-#include <vector>
+#include "GpuBuffer.h"
+#include "InstanceAttributes.h"
+
+// Layout of one instance record in the instance buffer
+enum class InstanceBufferFormat
+{
+    MAT4_FLOAT32  // Four vec4 columns: std430 mat4, divisor attributes or RGBA32F texels
+};
+
+// GPU copy of the matrix column, bound directly by every render path
+struct InstanceBufferHandle
+{
+    unsigned int buffer = 0;
+    size_t sizeBytes = 0;      // Bytes holding instance data
+    size_t capacityBytes = 0;  // Allocated bytes, grown geometrically
+    int count = 0;
+    unsigned int stride = 0;  // Bytes per instance
+    InstanceBufferFormat format = InstanceBufferFormat::MAT4_FLOAT32;
+};
 
 class InstanceManager
 {
@@ -13,6 +33,9 @@ public:
     bool initialize(int maxInstances = 100000);
     void setInstanceCount(int count);
     void updateInstanceData();
+    // Uploads matrices owned by the caller (a mapped scene snapshot) in place of the grid.
+    // The matrix column borrows them, so they must stay valid until the next update.
+    void setInstanceData(const glm::mat4* matrices, int count);
     void cleanup();
 
     // Getters
@@ -24,14 +47,41 @@ public:
     {
         return _maxInstanceCount;
     }
-    unsigned int getInstanceVBO() const
+    const InstanceBufferHandle& getInstanceBuffer() const
+    {
+        return _instanceBuffer;
+    }
+    const InstanceAttributeStore& getAttributes() const
+    {
+        return _attributes;
+    }
+    const glm::mat4* getInstanceMatrices() const
     {
-        return _instanceVBO;
+        return _attributes.get<InstanceAttribute::MATRIX>();
     }
-    const std::vector<glm::mat4>& getInstanceMatrices() const
+    const glm::vec4* getInstanceBounds() const
     {
-        return _instanceMatrices;
+        return _attributes.get<InstanceAttribute::BOUNDS>();
     }
+    // GPU mirror of a column, bound at INSTANCE_ATTRIBUTE_BINDINGS
+    unsigned int getAttributeBuffer(InstanceAttribute attribute) const
+    {
+        return _columnBuffers[static_cast<int>(attribute)].getBuffer();
+    }
+    // Totals over every column's GPU mirror
+    size_t getAttributeSizeBytes() const;
+    size_t getAttributeCapacityBytes() const;
+
+    // Upload counters
+    uint64_t getUploadedBytes() const
+    {
+        return _uploadedBytes;
+    }
+    unsigned int getUploadCount() const
+    {
+        return _uploadCount;
+    }
+    unsigned int getAllocationCount() const;
 
     // Grid configuration
     void setSpacing(float spacing)
@@ -45,14 +95,20 @@ public:
 
 private:
     // Instance data
-    std::vector<glm::mat4> _instanceMatrices;
-    unsigned int _instanceVBO;
+    InstanceAttributeStore _attributes;
+    GpuBuffer _columnBuffers[INSTANCE_ATTRIBUTE_COUNT];  // One per column, names change when they reallocate
+    InstanceBufferHandle _instanceBuffer;                 // Describes the matrix column's buffer
     int _currentInstanceCount;
     int _maxInstanceCount;
 
     // Grid configuration
     float _gridSpacing;
 
+    // Upload statistics
+    uint64_t _uploadedBytes;
+    unsigned int _uploadCount;
+
     // Helper methods
     void _generateGridPositions();
+    void _uploadDirtyColumns();
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "PipelineStatistics.h"
+
+#include <iostream>
+#include <GL/glew.h>
+
+namespace {
+// Query targets, in QuerySet::queries order
+const GLenum QUERY_TARGETS[] = {GL_VERTICES_SUBMITTED_ARB, GL_VERTEX_SHADER_INVOCATIONS_ARB, GL_CLIPPING_INPUT_PRIMITIVES_ARB, GL_CLIPPING_OUTPUT_PRIMITIVES_ARB,
+                                GL_FRAGMENT_SHADER_INVOCATIONS_ARB, GL_TESS_EVALUATION_SHADER_INVOCATIONS_ARB};
+}  // namespace
+
+PipelineStatistics::PipelineStatistics() : _supported(false), _querySets{}, _currentSet(0), _active(false) {}
+
+PipelineStatistics::~PipelineStatistics() {
+  cleanup();
+}
+
+bool PipelineStatistics::initialize() {
+  _supported = GLEW_ARB_pipeline_statistics_query || GLEW_VERSION_4_6;
+  if (!_supported) {
+    std::cout << "ARB_pipeline_statistics_query not available, pipeline statistics disabled" << std::endl;
+    return false;
+  }
+
+  for (QuerySet& querySet : _querySets) {
+    glGenQueries(QUERY_COUNT, querySet.queries);
+    querySet.pending = false;
+  }
+
+  return true;
+}
+
+void PipelineStatistics::cleanup() {
+  if (!_supported) {
+    return;
+  }
+
+  for (QuerySet& querySet : _querySets) {
+    glDeleteQueries(QUERY_COUNT, querySet.queries);
+    querySet.pending = false;
+  }
+  _supported = false;
+}
+
+void PipelineStatistics::begin(RenderMethod method) {
+  if (!_supported || _active) {
+    return;
+  }
+
+  // Reuse the oldest set, harvesting its results first if the GPU is done with them
+  QuerySet& querySet = _querySets[_currentSet];
+  if (querySet.pending) {
+    _collect(querySet);
+  }
+
+  querySet.method = method;
+  for (int i = 0; i < QUERY_COUNT; ++i) {
+    glBeginQuery(QUERY_TARGETS[i], querySet.queries[i]);
+  }
+  _active = true;
+}
+
+void PipelineStatistics::end() {
+  if (!_supported || !_active) {
+    return;
+  }
+
+  for (int i = 0; i < QUERY_COUNT; ++i) {
+    glEndQuery(QUERY_TARGETS[i]);
+  }
+  _querySets[_currentSet].pending = true;
+  _currentSet = (_currentSet + 1) % FRAME_LATENCY;
+  _active = false;
+}
+
+void PipelineStatistics::_collect(QuerySet& querySet) {
+  querySet.pending = false;
+
+  // Drop the sample rather than stall when the GPU is still behind
+  GLuint available = 0;
+  glGetQueryObjectuiv(querySet.queries[QUERY_COUNT - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return;
+  }
+
+  GLuint64 values[QUERY_COUNT];
+  for (int i = 0; i < QUERY_COUNT; ++i) {
+    glGetQueryObjectui64v(querySet.queries[i], GL_QUERY_RESULT, &values[i]);
+  }
+
+  PipelineStatisticsResult& result = _results[static_cast<int>(querySet.method)];
+  result.valid = true;
+  result.verticesSubmitted = values[0];
+  result.vertexShaderInvocations = values[1];
+  result.clippingInputPrimitives = values[2];
+  result.clippingOutputPrimitives = values[3];
+  result.fragmentShaderInvocations = values[4];
+  result.tessEvaluationInvocations = values[5];
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include "RenderMethod.h"
+
+// Counters collected around one render path for one frame
+struct PipelineStatisticsResult {
+  bool valid = false;
+  uint64_t verticesSubmitted = 0;
+  uint64_t vertexShaderInvocations = 0;
+  uint64_t clippingInputPrimitives = 0;
+  uint64_t clippingOutputPrimitives = 0;
+  uint64_t fragmentShaderInvocations = 0;
+  uint64_t tessEvaluationInvocations = 0;  // Vertices generated by tessellation, 0 for the other paths
+};
+
+// ARB_pipeline_statistics_query wrapper. Results are read back a few frames late
+// so the CPU never waits on the GPU; without the extension begin/end are no-ops.
+class PipelineStatistics {
+public:
+  PipelineStatistics();
+  ~PipelineStatistics();
+
+  bool initialize();
+  void cleanup();
+
+  void begin(RenderMethod method);
+  void end();
+
+  bool isSupported() const {
+    return _supported;
+  }
+  const PipelineStatisticsResult& getResult(RenderMethod method) const {
+    return _results[static_cast<int>(method)];
+  }
+
+private:
+  static const int QUERY_COUNT = 6;
+  static const int FRAME_LATENCY = 3;
+
+  struct QuerySet {
+    unsigned int queries[QUERY_COUNT];
+    RenderMethod method;
+    bool pending;
+  };
+
+  bool _supported;
+  QuerySet _querySets[FRAME_LATENCY];
+  int _currentSet;
+  bool _active;
+  PipelineStatisticsResult _results[RENDER_METHOD_COUNT];
+
+  // Helper methods
+  void _collect(QuerySet& querySet);
+};
@@ -0,0 +1,129 @@
+#include "QualityController.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+// Exponential smoothing of the frame time
+const double SMOOTHING = 0.1;
+
+// Hysteresis band around the target and how long a frame time must stay outside it
+const double DEGRADE_ABOVE = 1.10;
+const double IMPROVE_BELOW = 0.80;
+const int DEGRADE_AFTER_FRAMES = 20;
+const int IMPROVE_AFTER_FRAMES = 60;
+
+// Frames to let a change settle before judging again
+const int COOLDOWN_FRAMES = 30;
+
+const float LOD_BIAS_STEP = 0.5f;
+const float LOD_BIAS_MAX = 4.0f;
+
+const float RENDER_SCALE_STEP = 0.125f;
+const float RENDER_SCALE_MIN = 0.5f;
+}  // namespace
+
+QualityController::QualityController()
+    : _enabled(false), _targetMs(16.6f), _smoothedMs(0.0), _framesOverBudget(0), _framesUnderBudget(0), _cooldownFrames(0), _adjustmentCount(0) {}
+
+void QualityController::setEnabled(bool enabled) {
+  if (enabled == _enabled) {
+    return;
+  }
+  _enabled = enabled;
+
+  // Start from the user's settings either way
+  _settings = _userSettings;
+  _smoothedMs = 0.0;
+  _framesOverBudget = 0;
+  _framesUnderBudget = 0;
+  _cooldownFrames = 0;
+}
+
+void QualityController::setUserSettings(const QualitySettings& settings) {
+  _userSettings = settings;
+  if (!_enabled) {
+    _settings = settings;
+    return;
+  }
+
+  // The user's settings stay the upper bound on quality
+  _settings.lodBias = std::max(_settings.lodBias, settings.lodBias);
+  _settings.renderScale = std::min(_settings.renderScale, settings.renderScale);
+}
+
+void QualityController::update(double cpuMs, double gpuMs) {
+  if (!_enabled) {
+    return;
+  }
+
+  double frameMs = std::max(cpuMs, gpuMs);
+  _smoothedMs = _smoothedMs > 0.0 ? _smoothedMs + SMOOTHING * (frameMs - _smoothedMs) : frameMs;
+
+  if (_cooldownFrames > 0) {
+    _cooldownFrames--;
+    return;
+  }
+
+  _framesOverBudget = _smoothedMs > _targetMs * DEGRADE_ABOVE ? _framesOverBudget + 1 : 0;
+  _framesUnderBudget = _smoothedMs < _targetMs * IMPROVE_BELOW ? _framesUnderBudget + 1 : 0;
+
+  QualitySettings before = _settings;
+  bool changed = false;
+  const char* direction = "";
+  if (_framesOverBudget >= DEGRADE_AFTER_FRAMES) {
+    changed = _degrade(gpuMs > cpuMs);
+    direction = "over";
+  } else if (_framesUnderBudget >= IMPROVE_AFTER_FRAMES) {
+    changed = _improve();
+    direction = "under";
+  }
+
+  if (changed) {
+    _log(direction, before, cpuMs, gpuMs);
+    _adjustmentCount++;
+    _framesOverBudget = 0;
+    _framesUnderBudget = 0;
+    _cooldownFrames = COOLDOWN_FRAMES;
+  }
+}
+
+bool QualityController::_degrade(bool gpuBound) {
+  bool canScale = _settings.renderScale > RENDER_SCALE_MIN;
+  if (gpuBound && canScale) {
+    _settings.renderScale = std::max(RENDER_SCALE_MIN, _settings.renderScale - RENDER_SCALE_STEP);
+    return true;
+  }
+  if (_settings.lodBias < LOD_BIAS_MAX) {
+    _settings.lodBias = std::min(LOD_BIAS_MAX, _settings.lodBias + LOD_BIAS_STEP);
+    return true;
+  }
+  if (canScale) {
+    _settings.renderScale = std::max(RENDER_SCALE_MIN, _settings.renderScale - RENDER_SCALE_STEP);
+    return true;
+  }
+  return false;
+}
+
+bool QualityController::_improve() {
+  // Never better than what the user asked for, resolution first since it is the most visible
+  if (_settings.renderScale < _userSettings.renderScale) {
+    _settings.renderScale = std::min(_userSettings.renderScale, _settings.renderScale + RENDER_SCALE_STEP);
+    return true;
+  }
+  if (_settings.lodBias > _userSettings.lodBias) {
+    _settings.lodBias = std::max(_userSettings.lodBias, _settings.lodBias - LOD_BIAS_STEP);
+    return true;
+  }
+  return false;
+}
+
+void QualityController::_log(const char* direction, const QualitySettings& before, double cpuMs, double gpuMs) const {
+  std::ostringstream message;
+  message << std::fixed << std::setprecision(2) << "Adaptive quality: " << _smoothedMs << " ms " << direction << " target " << _targetMs << " ms (CPU " << cpuMs
+          << " ms, GPU " << gpuMs << " ms), LOD bias " << before.lodBias << " -> " << _settings.lodBias
+          << ", render scale " << before.renderScale << " -> " << _settings.renderScale;
+  std::cout << message.str() << std::endl;
+}
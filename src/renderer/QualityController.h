@@ -0,0 +1,59 @@
+#pragma once
+
+// Lowest render scale the user can pick, from the UI or the command line
+const float MIN_USER_RENDER_SCALE = 0.25f;
+
+// Quality knobs the controller may change, from the user's settings
+struct QualitySettings {
+  float lodBias = 0.0f;      // Positive values switch to coarser sphere LODs earlier
+  float renderScale = 1.0f;  // Fraction of the window resolution the scene is rendered at
+};
+
+// Holds a frame-time budget by stepping quality knobs, with hysteresis so it does not oscillate.
+// The frame cost is the slower of the CPU and GPU times, since frames are pipelined.
+// A GPU-bound frame lowers the render scale first (fill cost), anything else raises the LOD bias (vertex cost).
+class QualityController {
+public:
+  QualityController();
+
+  void setEnabled(bool enabled);
+  bool isEnabled() const {
+    return _enabled;
+  }
+  void setTargetFrameTimeMs(float targetMs) {
+    _targetMs = targetMs;
+  }
+
+  // Feeds one frame's measurements, may adjust the settings
+  void update(double cpuMs, double gpuMs);
+
+  // Settings to render with, the user's settings when disabled
+  const QualitySettings& getSettings() const {
+    return _settings;
+  }
+  void setUserSettings(const QualitySettings& settings);
+
+  double getSmoothedFrameTimeMs() const {
+    return _smoothedMs;
+  }
+  unsigned int getAdjustmentCount() const {
+    return _adjustmentCount;
+  }
+
+private:
+  bool _enabled;
+  float _targetMs;
+  QualitySettings _userSettings;
+  QualitySettings _settings;
+
+  double _smoothedMs;
+  int _framesOverBudget;
+  int _framesUnderBudget;
+  int _cooldownFrames;
+  unsigned int _adjustmentCount;
+
+  // Helper methods
+  bool _degrade(bool gpuBound);
+  bool _improve();
+  void _log(const char* direction, const QualitySettings& before, double cpuMs, double gpuMs) const;
+};
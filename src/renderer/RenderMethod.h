@@ -1,5 +1,8 @@
 #pragma once
 
-enum class RenderMethod { INSTANCED = 0, MULTIDRAW = 1, MULTIDRAW_INDIRECT = 2 };
+enum class RenderMethod { INSTANCED = 0, MULTIDRAW = 1, MULTIDRAW_INDIRECT = 2, VERTEX_PULLING = 3, CLUSTER_CULLING = 4, TESSELLATION = 5 };
 
-const char* const RENDER_METHOD_NAMES[] = {"Instanced Rendering", "MultiDraw Rendering", "MultiDraw Indirect Rendering"};
\ No newline at end of file
+const char* const RENDER_METHOD_NAMES[] = {"Instanced Rendering", "MultiDraw Rendering", "MultiDraw Indirect Rendering", "Vertex Pulling Rendering",
+                                            "Cluster Culled Rendering", "Tessellated Rendering"};
+
+const int RENDER_METHOD_COUNT = sizeof(RENDER_METHOD_NAMES) / sizeof(RENDER_METHOD_NAMES[0]);
@@ -0,0 +1,84 @@
+#include "RenderTarget.h"
+
+#include <iostream>
+#include <GL/glew.h>
+
+RenderTarget::RenderTarget() : _framebuffer(0), _colorRenderbuffer(0), _depthRenderbuffer(0), _width(0), _height(0) {}
+
+RenderTarget::~RenderTarget() {
+  cleanup();
+}
+
+bool RenderTarget::initialize() {
+  glGenFramebuffers(1, &_framebuffer);
+  glGenRenderbuffers(1, &_colorRenderbuffer);
+  glGenRenderbuffers(1, &_depthRenderbuffer);
+  if (_framebuffer == 0 || _colorRenderbuffer == 0 || _depthRenderbuffer == 0) {
+    std::cerr << "Failed to generate render target" << std::endl;
+    cleanup();
+    return false;
+  }
+  return true;
+}
+
+void RenderTarget::cleanup() {
+  if (_framebuffer != 0) {
+    glDeleteFramebuffers(1, &_framebuffer);
+    _framebuffer = 0;
+  }
+  if (_colorRenderbuffer != 0) {
+    glDeleteRenderbuffers(1, &_colorRenderbuffer);
+    _colorRenderbuffer = 0;
+  }
+  if (_depthRenderbuffer != 0) {
+    glDeleteRenderbuffers(1, &_depthRenderbuffer);
+    _depthRenderbuffer = 0;
+  }
+  _width = 0;
+  _height = 0;
+}
+
+bool RenderTarget::resize(int width, int height) {
+  if (_framebuffer == 0) {
+    return false;
+  }
+  if (width == _width && height == _height) {
+    return true;
+  }
+
+  glBindRenderbuffer(GL_RENDERBUFFER, _colorRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorRenderbuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbuffer);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Render target incomplete at " << width << "x" << height << " (status 0x" << std::hex << status << std::dec << ")" << std::endl;
+    _width = 0;
+    _height = 0;
+    return false;
+  }
+
+  _width = width;
+  _height = height;
+  return true;
+}
+
+void RenderTarget::bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+  glViewport(0, 0, _width, _height);
+}
+
+void RenderTarget::blitToDefault(int width, int height) const {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, _width, _height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, width, height);
+}
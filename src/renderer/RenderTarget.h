@@ -0,0 +1,36 @@
+#pragma once
+
+// Offscreen color + depth framebuffer for rendering below window resolution.
+// The scene is drawn at the reduced size and upscaled to the default framebuffer with a linear blit,
+// so fragment cost scales with the render scale while vertex cost stays the same.
+class RenderTarget {
+public:
+  RenderTarget();
+  ~RenderTarget();
+
+  bool initialize();
+  void cleanup();
+
+  // Reallocates the attachments when the size changes
+  bool resize(int width, int height);
+
+  // Binds the framebuffer and sets the viewport to its size
+  void bind() const;
+
+  // Upscales the color attachment into the default framebuffer, which stays bound afterwards
+  void blitToDefault(int width, int height) const;
+
+  int getWidth() const {
+    return _width;
+  }
+  int getHeight() const {
+    return _height;
+  }
+
+private:
+  unsigned int _framebuffer;
+  unsigned int _colorRenderbuffer;
+  unsigned int _depthRenderbuffer;
+  int _width;
+  int _height;
+};
@@ -1,8 +1,20 @@
 #include "Renderer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "GLStateCache.h"
+#include "../utils/AllocationCounter.h"
+#include "../utils/GLCallCounter.h"
+#include "../utils/Profiler.h"
+
+namespace {
+// Spacing of recorded camera keyframes
+const double CAMERA_RECORD_INTERVAL = 0.1;
+}  // namespace
 
 bool Renderer::init(GLFWwindow* win) {
   _window = win;
@@ -14,6 +26,7 @@ bool Renderer::init(GLFWwindow* win) {
     std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(err) << std::endl;
     return false;
   }
+  GLCallCounter::install();
 
   // Set up OpenGL options
   glEnable(GL_DEPTH_TEST);
@@ -24,6 +37,10 @@ bool Renderer::init(GLFWwindow* win) {
   int width, height;
   glfwGetFramebufferSize(_window, &width, &height);
   glViewport(0, 0, width, height);
+  _framebufferWidth = width;
+  _framebufferHeight = height;
+  _viewportWidth = width;
+  _viewportHeight = static_cast<float>(height);
 
   // Set clear color
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -43,18 +60,12 @@ bool Renderer::init(GLFWwindow* win) {
 }
 
 bool Renderer::_initializeComponents() {
-  // Initialize shader manager with embedded shaders
+  // Initialize shader manager with embedded shaders, variants beyond the default compile on first use
   if (!_shaderManager.loadEmbeddedShaders()) {
     std::cerr << "Failed to load embedded shaders" << std::endl;
     return false;
   }
 
-  // Load multidraw shaders
-  if (!_shaderManager.loadMultiDrawShaders()) {
-    std::cerr << "Failed to load multidraw shaders" << std::endl;
-    return false;
-  }
-
   // Initialize geometry renderer
   if (!_geometryRenderer.initialize()) {
     std::cerr << "Failed to initialize geometry renderer" << std::endl;
@@ -79,6 +90,20 @@ bool Renderer::_initializeComponents() {
   // Set shader manager reference for multidraw rendering
   _geometryRenderer.setShaderManager(&_shaderManager);
 
+  // GPU frame time for the adaptive quality controller
+  _gpuTimer.initialize();
+  _shadowTimer.initialize();
+  _renderInfo.shadowsAvailable = _geometryRenderer.areShadowsAvailable();
+
+  // Optional, frames render at window resolution without it
+  _renderTarget.initialize();
+
+  // Initialize frame preparation (culling, LOD, sort, draw commands)
+  if (!_framePipeline.initialize(&_threadPool)) {
+    std::cerr << "Failed to initialize frame pipeline" << std::endl;
+    return false;
+  }
+
   // Initialize UI manager
   if (!_uiManager.initialize(_window)) {
     std::cerr << "Failed to initialize UI manager" << std::endl;
@@ -88,6 +113,15 @@ bool Renderer::_initializeComponents() {
   // Setup UI callbacks
   _setupUICallbacks();
 
+  // Initialize instance count to match UI state
+  const UIState& uiState = _uiManager.getUIState();
+  _handleInstanceCountChange(uiState.currentInstanceCount);
+  _handleRenderMethodChange(uiState.renderMethod);
+  _handleInstanceDataSourceChange(uiState.instanceDataSource);
+  _handleVertexFormatChange(uiState.vertexFormat);
+  _handleSphereTopologyChange(uiState.sphereTopology);
+  _appliedUIState = uiState;
+
   // Setup input callbacks
   _setupInputCallbacks();
 
@@ -101,16 +135,155 @@ void Renderer::_setupUICallbacks() {
 
   _uiManager.setRenderMethodCallback([this](RenderMethod method) { _handleRenderMethodChange(method); });
 
-  // Initialize instance count to match UI state
-  const UIState& uiState = _uiManager.getUIState();
-  _handleInstanceCountChange(uiState.currentInstanceCount);
-  _handleRenderMethodChange(uiState.renderMethod);
+  _uiManager.setInstanceDataSourceCallback([this](InstanceDataSource source) { _handleInstanceDataSourceChange(source); });
+
+  _uiManager.setVertexFormatCallback([this](VertexFormat format) { _handleVertexFormatChange(format); });
+
+  _uiManager.setSphereTopologyCallback([this](SphereTopology topology) { _handleSphereTopologyChange(topology); });
+
+  _uiManager.setSaveSceneCallback([this]() { saveScene("scene_snapshot.bin"); });
+
+#ifdef ENABLE_PROFILER
+  _uiManager.setDumpTraceCallback([]() { Profiler::writeChromeTrace("cpu_trace.json"); });
+#endif
 }
 
 void Renderer::handleInput(double deltaTime) {
+  PROFILE_ZONE("Renderer::handleInput");
+
   // Handle orbit camera input (this will internally call updateViewMatrix if
-  // needed)
-  _camera.handleMouseInput(_window, deltaTime);
+  // needed), a playing camera path owns the camera instead
+  if (!_cameraPathPlaying) {
+    _camera.handleMouseInput(_window, deltaTime);
+  }
+
+  // Keyframes at a fixed spacing of wall-clock time, playback interpolates between them
+  if (!_recordingFile.empty()) {
+    _recordingTime += deltaTime;
+    if (_recordingTime >= _nextRecordTime) {
+      CameraKeyframe keyframe;
+      keyframe.time = _recordingTime;
+      keyframe.azimuth = _camera.getAzimuth();
+      keyframe.elevation = _camera.getElevation();
+      keyframe.distance = _camera.getDistance();
+      keyframe.center = _camera.getOrbitCenter();
+      _recordedPath.addKeyframe(keyframe);
+      _nextRecordTime = _recordingTime + CAMERA_RECORD_INTERVAL;
+    }
+  }
+}
+
+bool Renderer::loadCameraPath(const std::string& path) {
+  if (!_cameraPath.load(path)) {
+    return false;
+  }
+  std::cout << "Camera path: " << _cameraPath.getKeyframeCount() << " keyframes, " << _cameraPath.getDuration() << " s" << std::endl;
+  _cameraPathPlaying = true;
+  restartCameraPath();
+  return true;
+}
+
+void Renderer::restartCameraPath() {
+  _cameraPathFrame = 0;
+}
+
+bool Renderer::startCameraRecording(const std::string& path) {
+  if (path.empty()) {
+    return false;
+  }
+  _recordedPath.clear();
+  _recordingFile = path;
+  _recordingTime = 0.0;
+  _nextRecordTime = 0.0;
+  return true;
+}
+
+void Renderer::stopCameraRecording() {
+  if (_recordingFile.empty()) {
+    return;
+  }
+  if (_recordedPath.save(_recordingFile)) {
+    std::cout << "Camera path recorded: " << _recordedPath.getKeyframeCount() << " keyframes to " << _recordingFile << std::endl;
+  }
+  _recordingFile.clear();
+}
+
+bool Renderer::saveScene(const std::string& path) const {
+  const UIState& uiState = _uiManager.getUIState();
+  SceneSettings settings;
+  settings.sphereRadius = uiState.sphereRadius;
+  settings.sphereSegments = uiState.sphereSegments;
+  settings.sphereTopology = uiState.sphereTopology;
+  settings.renderMethod = uiState.renderMethod;
+  settings.instanceDataSource = uiState.instanceDataSource;
+  settings.vertexFormat = uiState.vertexFormat;
+  settings.depthSortMode = uiState.depthSortMode;
+  settings.frustumCulling = uiState.frustumCulling;
+  settings.lodSelection = uiState.lodSelection;
+  settings.lodBias = uiState.lodBias;
+  settings.renderScale = uiState.renderScale;
+  settings.cameraAzimuth = _camera.getAzimuth();
+  settings.cameraElevation = _camera.getElevation();
+  settings.cameraDistance = _camera.getDistance();
+  settings.cameraCenter = _camera.getOrbitCenter();
+  settings.cameraFov = _camera.getFov();
+
+  const InstanceBufferHandle& instanceBuffer = _instanceManager.getInstanceBuffer();
+  if (!SceneSnapshot::save(path, settings, _instanceManager.getInstanceMatrices(), static_cast<size_t>(instanceBuffer.count))) {
+    return false;
+  }
+  std::cout << "Scene snapshot written to " << path << " (" << instanceBuffer.count << " instances)" << std::endl;
+  return true;
+}
+
+bool Renderer::loadScene(const std::string& path) {
+  if (!_scene.load(path)) {
+    return false;
+  }
+  const SceneSettings& settings = _scene.getSettings();
+  int instanceCount = static_cast<int>(_scene.getInstanceCount());
+
+  UIState uiState = _uiManager.getUIState();
+  uiState.currentInstanceCount = instanceCount;
+  uiState.maxInstanceCount = std::max(uiState.maxInstanceCount, instanceCount);
+  uiState.sphereRadius = settings.sphereRadius;
+  uiState.sphereSegments = settings.sphereSegments;
+  uiState.sphereTopology = settings.sphereTopology;
+  uiState.renderMethod = settings.renderMethod;
+  uiState.instanceDataSource = settings.instanceDataSource;
+  uiState.vertexFormat = settings.vertexFormat;
+  uiState.depthSortMode = settings.depthSortMode;
+  uiState.frustumCulling = settings.frustumCulling;
+  uiState.lodSelection = settings.lodSelection;
+  uiState.lodBias = settings.lodBias;
+  uiState.renderScale = std::max(MIN_USER_RENDER_SCALE, std::min(1.0f, settings.renderScale));
+  _uiManager.setUIState(uiState);
+
+  // Upload straight from the mapping, then apply the rest without regenerating the grid
+  _instanceManager.setInstanceData(_scene.getInstances(), instanceCount);
+  _appliedUIState.currentInstanceCount = instanceCount;
+  _applyUIState(uiState);
+  _geometryRenderer.bindInstanceData(_instanceManager);
+  _updatePerformanceInfo();
+
+  _camera.setPerspective(settings.cameraFov, _camera.getAspectRatio(), _camera.getNearPlane(), _camera.getFarPlane());
+  _camera.updateProjectionMatrix();
+  _camera.setOrbitCenter(settings.cameraCenter);
+  _camera.setDistance(settings.cameraDistance);
+  _camera.setAngles(settings.cameraAzimuth, settings.cameraElevation);
+
+  std::cout << "Scene snapshot loaded from " << path << " (" << instanceCount << " instances)" << std::endl;
+  return true;
+}
+
+void Renderer::_advanceCameraPath() {
+  if (!_cameraPathPlaying) {
+    return;
+  }
+  CameraKeyframe keyframe = _cameraPath.sampleFrame(_cameraPathFrame++);
+  _camera.setOrbitCenter(keyframe.center);
+  _camera.setDistance(keyframe.distance);
+  _camera.setAngles(keyframe.azimuth, keyframe.elevation);
 }
 
 void Renderer::_setupInputCallbacks() {
@@ -126,12 +299,20 @@ void Renderer::_setupInputCallbacks() {
 }
 
 void Renderer::_handleInstanceCountChange(int count) {
+  PROFILE_ZONE("Renderer::handleInstanceCountChange");
+
   _instanceManager.setInstanceCount(count);
   _instanceManager.updateInstanceData();
   _geometryRenderer.bindInstanceData(_instanceManager);
+  _scene.close();  // Back on the grid, the mapped instances are no longer read
 
   // Update UI performance info
-  _uiManager.updatePerformanceInfo(_geometryRenderer.getSphereGeometry(), count);
+  _updatePerformanceInfo();
+  _renderInfo.instanceBufferBytes = _instanceManager.getAttributeSizeBytes();
+  _renderInfo.instanceBufferCapacityBytes = _instanceManager.getAttributeCapacityBytes();
+  _renderInfo.instanceBufferAllocations = _instanceManager.getAllocationCount();
+  _renderInfo.instanceUploadedBytes = _instanceManager.getUploadedBytes();
+  _renderInfo.instanceUploadCount = _instanceManager.getUploadCount();
 }
 
 void Renderer::_handleSphereParamsChange(float radius, int segments) {
@@ -140,48 +321,414 @@ void Renderer::_handleSphereParamsChange(float radius, int segments) {
   _geometryRenderer.bindInstanceData(_instanceManager);
 
   // Update UI performance info
-  _uiManager.updatePerformanceInfo(_geometryRenderer.getSphereGeometry(), _instanceManager.getCurrentInstanceCount());
+  _updatePerformanceInfo();
+}
+
+void Renderer::_handleVertexFormatChange(VertexFormat format) {
+  _geometryRenderer.setVertexFormat(format);
+  _updatePerformanceInfo();
+}
+
+void Renderer::_handleSphereTopologyChange(SphereTopology topology) {
+  _geometryRenderer.setSphereTopology(topology);
+  _updatePerformanceInfo();
+}
+
+void Renderer::_updatePerformanceInfo() {
+  const SphereGeometry& geometry = _geometryRenderer.getSphereGeometry();
+  unsigned int instanceCount = static_cast<unsigned int>(_instanceManager.getCurrentInstanceCount());
+  _renderInfo.vertexCount = geometry.vertexCount * instanceCount;
+  _renderInfo.triangleCount = (geometry.indexCount / 3) * instanceCount;
+  _renderInfo.vertexBufferBytes = _geometryRenderer.getVertexBufferBytes();
+  _renderInfo.sphereClusterCount = _geometryRenderer.getClusterCuller().getLodClusterCount(0);
 }
 
 void Renderer::_handleRenderMethodChange(RenderMethod method) {
   _geometryRenderer.setRenderMethod(method);
 }
 
+void Renderer::_handleInstanceDataSourceChange(InstanceDataSource source) {
+  _geometryRenderer.setInstanceDataSource(source);
+}
+
+void Renderer::setRenderMethod(RenderMethod method) {
+  // Keep the UI in sync so the next frame renders with this method
+  UIState uiState = _uiManager.getUIState();
+  uiState.renderMethod = method;
+  _uiManager.setUIState(uiState);
+  _handleRenderMethodChange(method);
+}
+
+RenderMethod Renderer::getRenderMethod() const {
+  return _uiManager.getUIState().renderMethod;
+}
+
+const PipelineStatistics& Renderer::getPipelineStatistics() const {
+  return _geometryRenderer.getPipelineStatistics();
+}
+
+void Renderer::setDepthSortMode(DepthSortMode mode) {
+  UIState uiState = _uiManager.getUIState();
+  uiState.depthSortMode = mode;
+  _uiManager.setUIState(uiState);
+}
+
+DepthSortMode Renderer::getDepthSortMode() const {
+  return _uiManager.getUIState().depthSortMode;
+}
+
+double Renderer::getLastSortTimeMs() const {
+  return _framePipeline.getStats().sortMs;
+}
+
+void Renderer::setPipelinedFrames(bool pipelined) {
+  UIState uiState = _uiManager.getUIState();
+  uiState.pipelinedFrames = pipelined;
+  _uiManager.setUIState(uiState);
+}
+
+void Renderer::setRenderScale(float scale) {
+  UIState uiState = _uiManager.getUIState();
+  uiState.renderScale = std::max(MIN_USER_RENDER_SCALE, std::min(1.0f, scale));
+  _uiManager.setUIState(uiState);
+}
+
+float Renderer::getRenderScale() const {
+  return _uiManager.getUIState().renderScale;
+}
+
+const GLCallFrameStats& Renderer::getLastGLCallStats() const {
+  return GLCallCounter::getLastFrame();
+}
+
+double Renderer::getLastGpuFrameMs() const {
+  return _gpuTimer.getLastMs() + getLastShadowGpuMs();
+}
+
+void Renderer::setShadowsEnabled(bool enabled) {
+  UIState uiState = _uiManager.getUIState();
+  uiState.shadows = enabled && _geometryRenderer.areShadowsAvailable();
+  _uiManager.setUIState(uiState);
+}
+
+void Renderer::setSphereTopology(SphereTopology topology) {
+  UIState uiState = _uiManager.getUIState();
+  uiState.sphereTopology = topology;
+  _uiManager.setUIState(uiState);
+  _handleSphereTopologyChange(topology);
+}
+
+SphereTopology Renderer::getSphereTopology() const {
+  return _uiManager.getUIState().sphereTopology;
+}
+
+bool Renderer::areShadowsEnabled() const {
+  return _uiManager.getUIState().shadows;
+}
+
+double Renderer::getLastShadowGpuMs() const {
+  return areShadowsEnabled() ? _shadowTimer.getLastMs() : 0.0;
+}
+
+void Renderer::beginFrame() {
+  _advanceCameraPath();
+  _beginFrame(_camera, _uiManager.getUIState());
+}
+
+void Renderer::_beginFrame(const Camera& camera, const UIState& uiState) {
+  PROFILE_ZONE("Renderer::beginFrame");
+
+  _framePipeline.setPipelined(uiState.pipelinedFrames);
+
+  // Knobs come from the controller when adaptive quality is on, else straight from the UI
+  QualitySettings userQuality;
+  userQuality.lodBias = uiState.lodBias;
+  userQuality.renderScale = uiState.renderScale;
+  _qualityController.setEnabled(uiState.adaptiveQuality);
+  _qualityController.setTargetFrameTimeMs(uiState.targetFrameTimeMs);
+  _qualityController.setUserSettings(userQuality);
+  const QualitySettings& quality = _qualityController.getSettings();
+  _frameRenderScale = quality.renderScale;
+
+  // Snapshot of everything the preparation reads; instance data only changes after acquireFrame
+  FrameInputs inputs;
+  inputs.instanceBounds = _instanceManager.getInstanceBounds();
+  inputs.instanceCount = static_cast<size_t>(_instanceManager.getInstanceBuffer().count);
+  inputs.viewMatrix = camera.getViewMatrix();
+  inputs.projectionMatrix = camera.getProjectionMatrix();
+  inputs.viewportHeight = _viewportHeight * _frameRenderScale;  // LODs follow the pixels actually rendered
+  inputs.sphereRadius = _geometryRenderer.getSphereRadius();
+  inputs.lodCount = _geometryRenderer.getSphereLodCount();
+  for (int lod = 0; lod < inputs.lodCount; ++lod) {
+    inputs.lods[lod] = _geometryRenderer.getSphereLods()[lod];
+  }
+  inputs.frustumCulling = uiState.frustumCulling;
+  inputs.lodSelection = uiState.lodSelection || uiState.adaptiveQuality;
+  inputs.lodBias = quality.lodBias;
+  inputs.sortMode = uiState.depthSortMode;
+
+  _framePipeline.beginFrame(inputs);
+  _frameBegun = true;
+}
+
 void Renderer::render() {
+  PROFILE_ZONE("Renderer::render");
+
+  if (!_frameBegun) {
+    beginFrame();
+  }
+
   // Clear screen completely
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   // Start UI frame
   _uiManager.newFrame();
 
-  // Get current render method from UI
-  RenderMethod currentMethod = _uiManager.getUIState().renderMethod;
-
-  // Render geometry using the selected method
-  switch (currentMethod) {
-    case RenderMethod::INSTANCED:
-      _geometryRenderer.renderInstanced(_instanceManager, _camera);
-      break;
-    case RenderMethod::MULTIDRAW:
-      _geometryRenderer.renderMultiDraw(_instanceManager, _camera);
-      break;
-    case RenderMethod::MULTIDRAW_INDIRECT:
-      _geometryRenderer.renderMultiDrawIndirect(_instanceManager, _camera);
-      break;
-  }
+  _renderFrame(_camera, _uiManager.getUIState());
 
   // Render UI
+  _uiManager.setRenderInfo(_renderInfo);
   _uiManager.render();
 }
+
+void Renderer::_renderFrame(const Camera& camera, const UIState& uiState) {
+  // ImGui and anything else between frames may have changed bindings behind the cache
+  GLStateCache::beginFrame();
+  GLCallCounter::beginFrame();
+
+  // Culled, LOD-grouped and sorted draw data, prepared while the previous frame was presented
+  const PreparedFrame& frame = _framePipeline.acquireFrame();
+
+  // Below full resolution the scene goes to the offscreen target, upscaled before the UI is drawn
+  int renderWidth = _viewportWidth;
+  int renderHeight = static_cast<int>(_viewportHeight);
+  bool scaled = false;
+  if (_frameRenderScale < 1.0f) {
+    int scaledWidth = std::max(1, static_cast<int>(std::lround(renderWidth * _frameRenderScale)));
+    int scaledHeight = std::max(1, static_cast<int>(std::lround(renderHeight * _frameRenderScale)));
+    scaled = _renderTarget.resize(scaledWidth, scaledHeight);
+  }
+
+  // Shadow cascades first, timed on their own
+  auto submitStart = std::chrono::steady_clock::now();
+  _geometryRenderer.setShadowsEnabled(uiState.shadows);
+  if (uiState.shadows) {
+    _shadowTimer.begin();
+    _geometryRenderer.renderShadows(frame, camera);
+    _shadowTimer.end();
+  }
+
+  // Render geometry using the selected method, the upscale counts towards the GPU time
+  _gpuTimer.begin();
+  if (scaled) {
+    _renderTarget.bind();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
+  _geometryRenderer.render(uiState.renderMethod, frame, camera);
+  if (scaled) {
+    _renderTarget.blitToDefault(renderWidth, renderHeight);
+    renderWidth = _renderTarget.getWidth();
+    renderHeight = _renderTarget.getHeight();
+  }
+  _gpuTimer.end();
+  _framePipeline.endFrame();
+  _frameBegun = false;
+  double submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+
+  // Preparation runs beside submission, the slower of the two bounds the CPU side
+  const FramePipelineStats& pipelineStats = _framePipeline.getStats();
+  _renderInfo.cpuFrameMs = std::max(pipelineStats.prepareMs, submitMs);
+  _renderInfo.shadowGpuMs = uiState.shadows ? _shadowTimer.getLastMs() : 0.0;
+  _renderInfo.gpuFrameMs = _gpuTimer.getLastMs() + _renderInfo.shadowGpuMs;
+  if (_gpuTimer.hasResult()) {
+    _qualityController.update(_renderInfo.cpuFrameMs, _renderInfo.gpuFrameMs);
+  }
+  _renderInfo.adaptiveLodBias = _qualityController.getSettings().lodBias;
+  _renderInfo.adaptiveRenderScale = _qualityController.getSettings().renderScale;
+
+  // GPU buffer memory, the cluster lists may grow with any frame
+  _renderInfo.gpuBufferBytes = GpuBuffer::getTotalCapacity();
+  _renderInfo.gpuBufferPeakBytes = GpuBuffer::getPeakTotalCapacity();
+  _renderInfo.gpuBufferAllocations = GpuBuffer::getTotalAllocationCount();
+  _renderInfo.renderWidth = renderWidth;
+  _renderInfo.renderHeight = renderHeight;
+  _renderInfo.qualityAdjustments = _qualityController.getAdjustmentCount();
+
+  // Heap allocations since the previous frame on every thread, zero once the frame loop is warm
+  uint64_t allocationCount = AllocationCounter::getAllocationCount();
+  uint64_t allocatedBytes = AllocationCounter::getAllocatedBytes();
+  _renderInfo.heapAllocationsPerFrame = allocationCount - _lastAllocationCount;
+  _renderInfo.heapBytesPerFrame = allocatedBytes - _lastAllocatedBytes;
+  _lastAllocationCount = allocationCount;
+  _lastAllocatedBytes = allocatedBytes;
+  _renderInfo.stateCacheStats = GLStateCache::getFrameStats();
+  _renderInfo.glCallStats = GLCallCounter::getLastFrame();
+
+  // Latest CPU and GPU counters for the UI
+  _renderInfo.framePipelineStats = pipelineStats;
+  _renderInfo.persistentlyMapped = _framePipeline.isPersistentlyMapped();
+  const PipelineStatistics& statistics = _geometryRenderer.getPipelineStatistics();
+  _renderInfo.pipelineStatisticsSupported = statistics.isSupported();
+  for (int i = 0; i < RENDER_METHOD_COUNT; ++i) {
+    _renderInfo.pipelineStatistics[i] = statistics.getResult(static_cast<RenderMethod>(i));
+  }
+}
+
+bool Renderer::startRenderThread() {
+  if (isRenderThreadRunning()) {
+    return true;
+  }
+
+  // UI changes are applied on the render thread from the snapshots instead of through callbacks
+  _uiManager.setInstanceCountCallback(nullptr);
+  _uiManager.setSphereParamsCallback(nullptr);
+  _uiManager.setRenderMethodCallback(nullptr);
+  _uiManager.setInstanceDataSourceCallback(nullptr);
+  _uiManager.setVertexFormatCallback(nullptr);
+  _uiManager.setSphereTopologyCallback(nullptr);
+  _uiManager.setSaveSceneCallback(nullptr);
+  _appliedUIState = _uiManager.getUIState();
+
+  // A context is current on at most one thread
+  glfwMakeContextCurrent(nullptr);
+  _renderThreadStopping.store(false);
+  _renderThread = std::thread(&Renderer::_renderThreadLoop, this);
+  return true;
+}
+
+void Renderer::stopRenderThread() {
+  if (!isRenderThreadRunning()) {
+    return;
+  }
+  _renderThreadStopping.store(true);
+  _renderThread.join();
+
+  // Back to the caller, catching up on UI changes the render thread did not see
+  glfwMakeContextCurrent(_window);
+  _applyUIState(_uiManager.getUIState());
+  _setupUICallbacks();
+}
+
+bool Renderer::submitFrame() {
+  PROFILE_ZONE("Renderer::submitFrame");
+
+  FrameSnapshot* snapshot = _snapshotQueue.beginWrite();
+  if (!snapshot) {
+    return false;
+  }
+
+  // Latest statistics from the render thread
+  while (UIRenderInfo* info = _renderInfoQueue.beginRead()) {
+    _uiManager.setRenderInfo(*info);
+    _renderInfoQueue.endRead();
+  }
+
+  _uiManager.buildFrame(snapshot->uiDrawData);
+  _advanceCameraPath();
+  snapshot->camera = _camera;
+  snapshot->uiState = _uiManager.getUIState();
+  snapshot->framebufferWidth = _framebufferWidth;
+  snapshot->framebufferHeight = _framebufferHeight;
+  _snapshotQueue.endWrite();
+  return true;
+}
+
+void Renderer::_renderThreadLoop() {
+  glfwMakeContextCurrent(_window);
+
+  bool hasPreviousFrame = false;
+  while (!_renderThreadStopping.load()) {
+    // Newest snapshot only, UI state is absolute so skipped snapshots lose nothing
+    FrameSnapshot* snapshot = _snapshotQueue.beginRead();
+    while (snapshot && _snapshotQueue.hasNewer()) {
+      _snapshotQueue.endRead();
+      snapshot = _snapshotQueue.beginRead();
+    }
+    if (!snapshot) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+
+    PROFILE_ZONE("RenderThread::Frame");
+
+    _applyUIState(snapshot->uiState);
+    if (snapshot->framebufferWidth != _viewportWidth || static_cast<float>(snapshot->framebufferHeight) != _viewportHeight) {
+      _viewportWidth = snapshot->framebufferWidth;
+      _viewportHeight = static_cast<float>(snapshot->framebufferHeight);
+      glViewport(0, 0, snapshot->framebufferWidth, snapshot->framebufferHeight);
+    }
+
+    // Same overlap as the single-threaded loop: prepare, present the previous frame, draw
+    _beginFrame(snapshot->camera, snapshot->uiState);
+    if (hasPreviousFrame) {
+      PROFILE_ZONE("glfwSwapBuffers");
+      glfwSwapBuffers(_window);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    _renderFrame(snapshot->camera, snapshot->uiState);
+    _uiManager.renderDrawData(snapshot->uiDrawData);
+    hasPreviousFrame = true;
+    _snapshotQueue.endRead();
+
+    // Dropped when the input thread has not caught up, the next frame brings fresher numbers
+    if (UIRenderInfo* info = _renderInfoQueue.beginWrite()) {
+      *info = _renderInfo;
+      _renderInfoQueue.endWrite();
+    }
+  }
+
+  glfwMakeContextCurrent(nullptr);
+}
+
+void Renderer::_applyUIState(const UIState& uiState) {
+  if (uiState.currentInstanceCount != _appliedUIState.currentInstanceCount) {
+    _handleInstanceCountChange(uiState.currentInstanceCount);
+  }
+  if (uiState.sphereRadius != _appliedUIState.sphereRadius || uiState.sphereSegments != _appliedUIState.sphereSegments) {
+    _handleSphereParamsChange(uiState.sphereRadius, uiState.sphereSegments);
+  }
+  if (uiState.renderMethod != _appliedUIState.renderMethod) {
+    _handleRenderMethodChange(uiState.renderMethod);
+  }
+  if (uiState.instanceDataSource != _appliedUIState.instanceDataSource) {
+    _handleInstanceDataSourceChange(uiState.instanceDataSource);
+  }
+  if (uiState.vertexFormat != _appliedUIState.vertexFormat) {
+    _handleVertexFormatChange(uiState.vertexFormat);
+  }
+  if (uiState.sphereTopology != _appliedUIState.sphereTopology) {
+    _handleSphereTopologyChange(uiState.sphereTopology);
+  }
+  _appliedUIState = uiState;
+}
+
 void Renderer::cleanup() {
+  stopRenderThread();
+  stopCameraRecording();
+
   // Cleanup all components
   _uiManager.cleanup();
+  _framePipeline.cleanup();
+  _gpuTimer.cleanup();
+  _shadowTimer.cleanup();
+  _renderTarget.cleanup();
   _geometryRenderer.cleanup();
   _instanceManager.cleanup();
   _shaderManager.cleanup();
 }
 
 void Renderer::onWindowResize(int width, int height) {
+  _framebufferWidth = width;
+  _framebufferHeight = height;
+
+  // The render thread applies the viewport with the next snapshot
+  if (!isRenderThreadRunning()) {
+    glViewport(0, 0, width, height);
+    _viewportWidth = width;
+    _viewportHeight = static_cast<float>(height);
+  }
+
   // Update camera aspect ratio and projection matrix
   float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
   _camera.setPerspective(_camera.getFov(), aspectRatio, _camera.getNearPlane(), _camera.getFarPlane());
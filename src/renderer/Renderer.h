@@ -1,11 +1,23 @@
 #pragma once
 
 #include "../ui/UIManager.h"
+#include "CameraPath.h"
+#include "FramePipeline.h"
 #include "GeometryRenderer.h"
+#include "GpuTimer.h"
 #include "InstanceManager.h"
 #include "OrbitCamera.h"
+#include "QualityController.h"
 #include "RenderMethod.h"
+#include "RenderTarget.h"
+#include "SceneSnapshot.h"
 #include "ShaderManager.h"
+#include "../utils/SpscQueue.h"
+#include "../utils/ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
 
 // Forward declarations
 struct GLFWwindow;
@@ -13,22 +25,118 @@ struct GLFWwindow;
 class Renderer {
 public:
   bool init(GLFWwindow *window);
+  // Starts preparing the next frame's draw data, overlapping the caller's buffer swap
+  void beginFrame();
   void render();
   void cleanup();
   void handleInput(double deltaTime);
   void onWindowResize(int width, int height);
 
+  // Render thread mode: GL moves to a dedicated thread, the caller keeps events, input and UI
+  bool startRenderThread();
+  void stopRenderThread();
+  bool isRenderThreadRunning() const {
+    return _renderThread.joinable();
+  }
+  // Input thread: builds the UI and hands camera and UI state to the render thread, false if it is still behind
+  bool submitFrame();
+
+  // Render method control (used by the benchmark)
+  void setRenderMethod(RenderMethod method);
+  RenderMethod getRenderMethod() const;
+  const PipelineStatistics& getPipelineStatistics() const;
+  void setDepthSortMode(DepthSortMode mode);
+  DepthSortMode getDepthSortMode() const;
+  double getLastSortTimeMs() const;
+  void setPipelinedFrames(bool pipelined);
+  void setRenderScale(float scale);
+  float getRenderScale() const;
+  double getLastGpuFrameMs() const;
+  const GLCallFrameStats& getLastGLCallStats() const;
+  void setShadowsEnabled(bool enabled);
+  void setSphereTopology(SphereTopology topology);
+  SphereTopology getSphereTopology() const;
+  bool areShadowsEnabled() const;
+  double getLastShadowGpuMs() const;
+
+  // Camera paths: playback replaces mouse input and advances one fixed timestep per frame
+  bool loadCameraPath(const std::string &path);
+  void restartCameraPath();
+  bool isPlayingCameraPath() const {
+    return _cameraPathPlaying;
+  }
+  // Recording samples the camera until stopCameraRecording (or cleanup) writes the file
+  bool startCameraRecording(const std::string &path);
+  void stopCameraRecording();
+
+  // Scene snapshots: instances, sphere parameters, render settings and camera
+  bool saveScene(const std::string &path) const;
+  bool loadScene(const std::string &path);
+
 private:
+  // Everything the render thread needs from the input thread for one frame
+  struct FrameSnapshot {
+    Camera camera;
+    UIState uiState;
+    UIDrawSnapshot uiDrawData;
+    int framebufferWidth = 0;
+    int framebufferHeight = 0;
+  };
+
   // Window reference
   GLFWwindow *_window = nullptr;
+  int _framebufferWidth = 0;
+  int _framebufferHeight = 0;
+
+  // Loaded scene, its mapping backs the instance data until the grid is regenerated
+  SceneSnapshot _scene;
+
+  // Camera path playback and recording
+  CameraPath _cameraPath;
+  bool _cameraPathPlaying = false;
+  long long _cameraPathFrame = 0;
+  CameraPath _recordedPath;
+  std::string _recordingFile;
+  double _recordingTime = 0.0;
+  double _nextRecordTime = 0.0;
+
+  // Worker threads for CPU kernels
+  ThreadPool _threadPool;
 
   // Modular components
   OrbitCamera _camera;
   InstanceManager _instanceManager;
   ShaderManager _shaderManager;
   GeometryRenderer _geometryRenderer;
+  FramePipeline _framePipeline;
   UIManager _uiManager;
 
+  // Frame timing and the quality knobs driven by it
+  GpuTimer _gpuTimer;
+  GpuTimer _shadowTimer;  // Separate span, GL_TIME_ELAPSED queries cannot nest
+  QualityController _qualityController;
+
+  // Offscreen target for rendering below window resolution
+  RenderTarget _renderTarget;
+  float _frameRenderScale = 1.0f;
+
+  // Render-side state (render thread when running, else main thread)
+  UIRenderInfo _renderInfo;
+  int _viewportWidth = 0;
+  float _viewportHeight = 1.0f;
+  bool _frameBegun = false;
+
+  // Heap allocation counters at the end of the previous frame
+  uint64_t _lastAllocationCount = 0;
+  uint64_t _lastAllocatedBytes = 0;
+
+  // Render thread and its queues: snapshots in, statistics out
+  std::thread _renderThread;
+  std::atomic<bool> _renderThreadStopping{false};
+  SpscQueue<FrameSnapshot, 2> _snapshotQueue;
+  SpscQueue<UIRenderInfo, 4> _renderInfoQueue;
+  UIState _appliedUIState;
+
   // Helper methods
   bool _initializeComponents();
   void _setupUICallbacks();
@@ -36,4 +144,13 @@ private:
   void _handleInstanceCountChange(int count);
   void _handleSphereParamsChange(float radius, int segments);
   void _handleRenderMethodChange(RenderMethod method);
+  void _handleInstanceDataSourceChange(InstanceDataSource source);
+  void _handleVertexFormatChange(VertexFormat format);
+  void _handleSphereTopologyChange(SphereTopology topology);
+  void _beginFrame(const Camera &camera, const UIState &uiState);
+  void _renderFrame(const Camera &camera, const UIState &uiState);
+  void _renderThreadLoop();
+  void _applyUIState(const UIState &uiState);
+  void _updatePerformanceInfo();
+  void _advanceCameraPath();
 };
@@ -0,0 +1,189 @@
+#include "SceneSnapshot.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+const char SNAPSHOT_MAGIC[8] = {'S', 'P', 'H', 'S', 'C', 'E', 'N', 'E'};
+const uint64_t INSTANCE_ALIGNMENT = 64;
+
+// Far past the UI's range, but low enough that the sphere's vertex counts stay small
+const int32_t MAX_SPHERE_SEGMENTS = 256;
+
+// On-disk layout, fixed-width fields only; append fields and bump VERSION to extend it
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t instanceOffset;
+  uint64_t instanceCount;
+  uint32_t instanceStride;
+
+  float sphereRadius;
+  int32_t sphereSegments;
+  int32_t renderMethod;
+  int32_t instanceDataSource;
+  int32_t vertexFormat;
+  int32_t depthSortMode;
+  uint32_t frustumCulling;
+  uint32_t lodSelection;
+  float lodBias;
+  float renderScale;
+
+  float cameraAzimuth;
+  float cameraElevation;
+  float cameraDistance;
+  float cameraCenter[3];
+  float cameraFov;
+
+  // Version 2
+  int32_t sphereTopology;
+};
+
+// Version 1 ended before the topology, its spheres were always UV spheres
+const uint32_t VERSION_1_HEADER_SIZE = offsetof(SnapshotHeader, sphereTopology);
+
+const int DEPTH_SORT_MODE_COUNT = sizeof(DEPTH_SORT_MODE_NAMES) / sizeof(DEPTH_SORT_MODE_NAMES[0]);
+const int INSTANCE_DATA_SOURCE_COUNT = sizeof(INSTANCE_DATA_SOURCE_NAMES) / sizeof(INSTANCE_DATA_SOURCE_NAMES[0]);
+
+bool inRange(int32_t value, int count) {
+  return value >= 0 && value < count;
+}
+
+// Puts a finished file in place of another in one step; a mapping of the old file keeps reading the old contents
+bool replaceFile(const std::string& source, const std::string& target) {
+#ifdef _WIN32
+  return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+}  // namespace
+
+bool SceneSnapshot::save(const std::string& path, const SceneSettings& settings, const glm::mat4* instances, size_t instanceCount) {
+  SnapshotHeader header = {};
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version = VERSION;
+  header.headerSize = sizeof(SnapshotHeader);
+  header.instanceOffset = (sizeof(SnapshotHeader) + INSTANCE_ALIGNMENT - 1) / INSTANCE_ALIGNMENT * INSTANCE_ALIGNMENT;
+  header.instanceCount = instanceCount;
+  header.instanceStride = sizeof(glm::mat4);
+
+  header.sphereRadius = settings.sphereRadius;
+  header.sphereSegments = settings.sphereSegments;
+  header.renderMethod = static_cast<int32_t>(settings.renderMethod);
+  header.instanceDataSource = static_cast<int32_t>(settings.instanceDataSource);
+  header.vertexFormat = static_cast<int32_t>(settings.vertexFormat);
+  header.depthSortMode = static_cast<int32_t>(settings.depthSortMode);
+  header.frustumCulling = settings.frustumCulling ? 1 : 0;
+  header.lodSelection = settings.lodSelection ? 1 : 0;
+  header.lodBias = settings.lodBias;
+  header.renderScale = settings.renderScale;
+
+  header.cameraAzimuth = settings.cameraAzimuth;
+  header.cameraElevation = settings.cameraElevation;
+  header.cameraDistance = settings.cameraDistance;
+  header.cameraCenter[0] = settings.cameraCenter.x;
+  header.cameraCenter[1] = settings.cameraCenter.y;
+  header.cameraCenter[2] = settings.cameraCenter.z;
+  header.cameraFov = settings.cameraFov;
+
+  header.sphereTopology = static_cast<int32_t>(settings.sphereTopology);
+
+  // The instances may point into a mapping of path itself (a loaded snapshot saved again), so path is
+  // never truncated: the snapshot is written next to it and renamed over it once complete
+  std::string temporaryPath = path + ".tmp";
+  std::ofstream file(temporaryPath, std::ios::binary);
+  if (!file) {
+    std::cerr << "Failed to write scene snapshot: " << temporaryPath << std::endl;
+    return false;
+  }
+  const char padding[INSTANCE_ALIGNMENT] = {};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(padding, static_cast<std::streamsize>(header.instanceOffset - sizeof(header)));
+  file.write(reinterpret_cast<const char*>(instances), static_cast<std::streamsize>(instanceCount * sizeof(glm::mat4)));
+  file.close();
+  if (!file || !replaceFile(temporaryPath, path)) {
+    std::cerr << "Failed to write scene snapshot: " << path << std::endl;
+    std::remove(temporaryPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool SceneSnapshot::load(const std::string& path) {
+  close();
+  if (!_file.open(path)) {
+    return false;
+  }
+
+  // Validate everything before trusting any offset
+  SnapshotHeader header;
+  bool valid = _file.getSize() >= sizeof(SnapshotHeader);
+  if (valid) {
+    std::memcpy(&header, _file.getData(), sizeof(header));
+    valid = std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+  }
+  if (!valid) {
+    std::cerr << "Not a scene snapshot: " << path << std::endl;
+    close();
+    return false;
+  }
+  if (header.version == 1 && header.headerSize == VERSION_1_HEADER_SIZE) {
+    header.sphereTopology = static_cast<int32_t>(SphereTopology::UV);
+  } else if (header.version != VERSION || header.headerSize != sizeof(SnapshotHeader)) {
+    std::cerr << "Unsupported scene snapshot version " << header.version << ": " << path << std::endl;
+    close();
+    return false;
+  }
+
+  if (header.instanceStride != sizeof(glm::mat4) || header.instanceOffset % INSTANCE_ALIGNMENT != 0 || header.instanceOffset > _file.getSize() ||
+      header.instanceCount > (_file.getSize() - header.instanceOffset) / sizeof(glm::mat4) || header.sphereSegments < 3 ||
+      header.sphereSegments > MAX_SPHERE_SEGMENTS || !std::isfinite(header.sphereRadius) || header.sphereRadius <= 0.0f || !std::isfinite(header.lodBias) ||
+      !std::isfinite(header.renderScale) || !inRange(header.renderMethod, RENDER_METHOD_COUNT) || !inRange(header.instanceDataSource, INSTANCE_DATA_SOURCE_COUNT) ||
+      !inRange(header.vertexFormat, VERTEX_FORMAT_COUNT) || !inRange(header.depthSortMode, DEPTH_SORT_MODE_COUNT) ||
+      !inRange(header.sphereTopology, SPHERE_TOPOLOGY_COUNT)) {
+    std::cerr << "Corrupt scene snapshot: " << path << std::endl;
+    close();
+    return false;
+  }
+
+  _settings.sphereRadius = header.sphereRadius;
+  _settings.sphereSegments = header.sphereSegments;
+  _settings.sphereTopology = static_cast<SphereTopology>(header.sphereTopology);
+  _settings.renderMethod = static_cast<RenderMethod>(header.renderMethod);
+  _settings.instanceDataSource = static_cast<InstanceDataSource>(header.instanceDataSource);
+  _settings.vertexFormat = static_cast<VertexFormat>(header.vertexFormat);
+  _settings.depthSortMode = static_cast<DepthSortMode>(header.depthSortMode);
+  _settings.frustumCulling = header.frustumCulling != 0;
+  _settings.lodSelection = header.lodSelection != 0;
+  _settings.lodBias = header.lodBias;
+  _settings.renderScale = header.renderScale;
+
+  _settings.cameraAzimuth = header.cameraAzimuth;
+  _settings.cameraElevation = header.cameraElevation;
+  _settings.cameraDistance = header.cameraDistance;
+  _settings.cameraCenter = glm::vec3(header.cameraCenter[0], header.cameraCenter[1], header.cameraCenter[2]);
+  _settings.cameraFov = header.cameraFov;
+
+  // The mapping is page aligned and the offset a multiple of 64, so the matrices can be read in place
+  _instances = reinterpret_cast<const glm::mat4*>(_file.getData() + header.instanceOffset);
+  _instanceCount = static_cast<size_t>(header.instanceCount);
+  return true;
+}
+
+void SceneSnapshot::close() {
+  _file.close();
+  _settings = SceneSettings();
+  _instances = nullptr;
+  _instanceCount = 0;
+}
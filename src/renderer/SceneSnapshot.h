@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "../geo/Sphere.h"
+#include "../utils/MappedFile.h"
+#include "DepthSortMode.h"
+#include "InstanceDataSource.h"
+#include "RenderMethod.h"
+#include "VertexFormat.h"
+
+// Everything besides the instances that decides what a frame costs
+struct SceneSettings {
+  float sphereRadius = 0.02f;
+  int sphereSegments = 16;
+  SphereTopology sphereTopology = SphereTopology::UV;
+  RenderMethod renderMethod = RenderMethod::INSTANCED;
+  InstanceDataSource instanceDataSource = InstanceDataSource::SSBO;
+  VertexFormat vertexFormat = VertexFormat::FLOAT32;
+  DepthSortMode depthSortMode = DepthSortMode::NONE;
+  bool frustumCulling = false;
+  bool lodSelection = false;
+  float lodBias = 0.0f;
+  float renderScale = 1.0f;
+
+  // Orbit camera
+  float cameraAzimuth = 0.0f;
+  float cameraElevation = 0.0f;
+  float cameraDistance = 1.0f;
+  glm::vec3 cameraCenter = glm::vec3(0.0f);
+  float cameraFov = 45.0f;
+};
+
+// Versioned binary capture of a scene: a fixed header with the settings, then the instance
+// matrices at a 64-byte aligned offset. Loading maps the file, so the instances are uploaded
+// straight from the mapping without a copy. Files are little-endian, as written.
+class SceneSnapshot {
+public:
+  static const uint32_t VERSION = 2;
+
+  // Safe to call with instances from a snapshot loaded from path: the file is replaced, not rewritten
+  static bool save(const std::string& path, const SceneSettings& settings, const glm::mat4* instances, size_t instanceCount);
+
+  bool load(const std::string& path);
+  void close();
+
+  const SceneSettings& getSettings() const {
+    return _settings;
+  }
+  // Points into the mapping, valid until close or the next load
+  const glm::mat4* getInstances() const {
+    return _instances;
+  }
+  size_t getInstanceCount() const {
+    return _instanceCount;
+  }
+
+private:
+  MappedFile _file;
+  SceneSettings _settings;
+  const glm::mat4* _instances = nullptr;
+  size_t _instanceCount = 0;
+};
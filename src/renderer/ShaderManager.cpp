@@ -1,51 +1,56 @@
 #include "ShaderManager.h"
+#include "GLStateCache.h"
 #include "../utils/ShaderLoader.h"
-#include "shaders/basic_fragment.h"
-#include "shaders/basic_vertex.h"
-#include "shaders/multidraw_fragment.h"
-#include "shaders/multidraw_vertex.h"
+#include "shaders/pulling_vertex.h"
+#include "shaders/shadow_fragment.h"
+#include "shaders/sphere_fragment.h"
+#include "shaders/sphere_spirv.h"
+#include "shaders/sphere_vertex.h"
+#include "shaders/tessellation_tess_control.h"
+#include "shaders/tessellation_tess_evaluation.h"
+#include "shaders/tessellation_vertex.h"
 
 #include <iostream>
 #include <GL/glew.h>
 #include <glm/gtc/type_ptr.hpp>
 
-ShaderManager::ShaderManager() : _instancedProgram(0), _multiDrawProgram(0) {}
+ShaderManager::ShaderManager()
+    : _vertexSource(GeneratedShaders::SPHERE_VERTEX_SHADER), _fragmentSource(GeneratedShaders::SPHERE_FRAGMENT_SHADER), _sourcesFromFiles(false) {}
 
 ShaderManager::~ShaderManager() {
   cleanup();
 }
 
 bool ShaderManager::loadShaders(const std::string& vertexPath, const std::string& fragmentPath) {
-  GLuint vertexShader = ShaderLoader::loadShader(vertexPath, GL_VERTEX_SHADER);
-  GLuint fragmentShader = ShaderLoader::loadShader(fragmentPath, GL_FRAGMENT_SHADER);
-
-  if (vertexShader == 0 || fragmentShader == 0) {
+  std::string vertexSource;
+  std::string fragmentSource;
+  if (!ShaderLoader::readSource(vertexPath, vertexSource) || !ShaderLoader::readSource(fragmentPath, fragmentSource)) {
     std::cerr << "Failed to load shaders: " << vertexPath << ", " << fragmentPath << std::endl;
     return false;
   }
 
-  _instancedProgram = ShaderLoader::createProgram(vertexShader, fragmentShader);
-
-  if (_instancedProgram == 0) {
+  // The default variant has no defines, so the files compile as they are
+  unsigned int program = _buildProgram(vertexSource, fragmentSource);
+  if (program == 0) {
     std::cerr << "Failed to create shader program" << std::endl;
     return false;
   }
 
+  // Every cached variant was built from the old sources
+  cleanup();
+  _vertexSource = vertexSource;
+  _fragmentSource = fragmentSource;
+  _sourcesFromFiles = true;
+
+  Program& cached = _programs[ShaderVariant().getBits()];
+  cached.id = program;
+  cached.fixedLocations = false;
   return true;
 }
 
 bool ShaderManager::loadEmbeddedShaders() {
-  GLuint vertexShader = ShaderLoader::loadShaderFromSource(GeneratedShaders::BASIC_VERTEX_SHADER, GL_VERTEX_SHADER);
-  GLuint fragmentShader = ShaderLoader::loadShaderFromSource(GeneratedShaders::BASIC_FRAGMENT_SHADER, GL_FRAGMENT_SHADER);
-
-  if (vertexShader == 0 || fragmentShader == 0) {
-    std::cerr << "Failed to load embedded shaders" << std::endl;
-    return false;
-  }
-
-  _instancedProgram = ShaderLoader::createProgram(vertexShader, fragmentShader);
-
-  if (_instancedProgram == 0) {
+  // The default variant up front, so broken sources fail at startup; the rest compile on first use
+  if (getProgram(ShaderVariant()) == 0) {
     std::cerr << "Failed to create shader program from embedded shaders" << std::endl;
     return false;
   }
@@ -53,42 +58,25 @@ bool ShaderManager::loadEmbeddedShaders() {
   return true;
 }
 
-bool ShaderManager::loadMultiDrawShaders() {
-  GLuint vertexShader = ShaderLoader::loadShaderFromSource(GeneratedShaders::MULTIDRAW_VERTEX_SHADER, GL_VERTEX_SHADER);
-  GLuint fragmentShader = ShaderLoader::loadShaderFromSource(GeneratedShaders::MULTIDRAW_FRAGMENT_SHADER, GL_FRAGMENT_SHADER);
-
-  if (vertexShader == 0 || fragmentShader == 0) {
-    std::cerr << "Failed to load multidraw shaders" << std::endl;
-    return false;
-  }
-
-  _multiDrawProgram = ShaderLoader::createProgram(vertexShader, fragmentShader);
-
-  if (_multiDrawProgram == 0) {
-    std::cerr << "Failed to create multidraw shader program" << std::endl;
-    return false;
-  }
-
-  return true;
+void ShaderManager::useProgram(RenderMethod method, InstanceDataSource source, VertexFormat format) const {
+  useProgram(sphereShaderVariant(method, source, format));
 }
 
-void ShaderManager::useProgram(RenderMethod method) const {
-  _currentMethod = method;
-  unsigned int program = _getCurrentProgram();
+void ShaderManager::useProgram(ShaderVariant variant) const {
+  _currentVariant = variant;
+  unsigned int program = getProgram(variant);
   if (program != 0) {
-    glUseProgram(program);
+    GLStateCache::useProgram(program);
   }
 }
 
 void ShaderManager::cleanup() {
-  if (_instancedProgram != 0) {
-    glDeleteProgram(_instancedProgram);
-    _instancedProgram = 0;
-  }
-  if (_multiDrawProgram != 0) {
-    glDeleteProgram(_multiDrawProgram);
-    _multiDrawProgram = 0;
+  for (const auto& entry : _programs) {
+    if (entry.second.id != 0) {
+      GLStateCache::deleteProgram(entry.second.id);
+    }
   }
+  _programs.clear();
 }
 
 void ShaderManager::setMatrix4(const std::string& name, const glm::mat4& matrix) const {
@@ -119,38 +107,149 @@ void ShaderManager::setVec3(const std::string& name, const glm::vec3& vector) co
   }
 }
 
+void ShaderManager::setMatrix4Array(const std::string& name, const glm::mat4* matrices, int count) const {
+  int location = _getUniformLocation(name);
+  if (location != -1) {
+    glUniformMatrix4fv(location, count, GL_FALSE, glm::value_ptr(matrices[0]));
+  }
+}
+
 int ShaderManager::_getUniformLocation(const std::string& name) const {
-  unsigned int program = _getCurrentProgram();
-  if (program == 0) {
+  const Program& program = _getProgramEntry(_currentVariant);
+  if (program.id == 0) {
     return -1;
   }
 
-  int location = glGetUniformLocation(program, name.c_str());
-  if (location == -1) {
-    std::cerr << "Warning: Uniform '" << name << "' not found in shader program" << std::endl;
+  // Embedded sources declare their locations, which SPIR-V needs and which spares a query per uniform
+  if (program.fixedLocations) {
+    for (const SphereUniform& uniform : SPHERE_UNIFORMS) {
+      if (name == uniform.name) {
+        return uniform.location;
+      }
+    }
+  } else {
+    int location = glGetUniformLocation(program.id, name.c_str());
+    if (location != -1) {
+      return location;
+    }
   }
 
-  return location;
+  std::cerr << "Warning: Uniform '" << name << "' not found in shader program" << std::endl;
+  return -1;
 }
 
-unsigned int ShaderManager::_getCurrentProgram() const {
-  switch (_currentMethod) {
-    case RenderMethod::INSTANCED:
-      return _instancedProgram;
-    case RenderMethod::MULTIDRAW:
-      return _multiDrawProgram;
-    default:
-      return _instancedProgram;
+unsigned int ShaderManager::_buildProgram(const std::string& vertexSource, const std::string& fragmentSource) {
+  GLuint vertexShader = ShaderLoader::loadShaderFromSource(vertexSource, GL_VERTEX_SHADER);
+  GLuint fragmentShader = ShaderLoader::loadShaderFromSource(fragmentSource, GL_FRAGMENT_SHADER);
+
+  if (vertexShader == 0 || fragmentShader == 0) {
+    return 0;
   }
+
+  return ShaderLoader::createProgram(vertexShader, fragmentShader);
 }
 
-unsigned int ShaderManager::getProgram(RenderMethod method) const {
-  switch (method) {
-    case RenderMethod::INSTANCED:
-      return _instancedProgram;
-    case RenderMethod::MULTIDRAW:
-      return _multiDrawProgram;
-    default:
-      return _instancedProgram;
+unsigned int ShaderManager::_buildTessellationProgram(ShaderVariant variant) const {
+  GLuint vertexShader = ShaderLoader::loadShaderFromSource(withDefines(GeneratedShaders::TESSELLATION_VERTEX_SHADER, variant), GL_VERTEX_SHADER);
+  GLuint controlShader = ShaderLoader::loadShaderFromSource(withDefines(GeneratedShaders::TESSELLATION_TESS_CONTROL_SHADER, variant), GL_TESS_CONTROL_SHADER);
+  GLuint evaluationShader = ShaderLoader::loadShaderFromSource(withDefines(GeneratedShaders::TESSELLATION_TESS_EVALUATION_SHADER, variant), GL_TESS_EVALUATION_SHADER);
+  GLuint fragmentShader = ShaderLoader::loadShaderFromSource(withDefines(_fragmentSource, variant), GL_FRAGMENT_SHADER);
+
+  if (vertexShader == 0 || controlShader == 0 || evaluationShader == 0 || fragmentShader == 0) {
+    return 0;
   }
-}
\ No newline at end of file
+
+  return ShaderLoader::createTessellationProgram(vertexShader, controlShader, evaluationShader, fragmentShader);
+}
+
+unsigned int ShaderManager::_buildSpirvVariant(ShaderVariant variant) {
+  if (!ShaderLoader::isSpirvSupported()) {
+    return 0;
+  }
+
+  for (const GeneratedShaders::SphereSpirvVariant& spirv : GeneratedShaders::SPHERE_SPIRV_VARIANTS) {
+    if (spirv.vertex == nullptr || variantFromDefines(spirv.defines) != variant) {
+      continue;
+    }
+
+    GLuint vertexShader = ShaderLoader::loadShaderFromSpirv(spirv.vertex, spirv.vertexWords, GL_VERTEX_SHADER);
+    GLuint fragmentShader = ShaderLoader::loadShaderFromSpirv(spirv.fragment, spirv.fragmentWords, GL_FRAGMENT_SHADER);
+    if (vertexShader == 0 || fragmentShader == 0) {
+      return 0;
+    }
+    return ShaderLoader::createProgram(vertexShader, fragmentShader);
+  }
+  return 0;
+}
+
+unsigned int ShaderManager::_buildVariant(ShaderVariant variant) const {
+  // The embedded SPIR-V holds vertex and fragment pairs only
+  if (variant.has(ShaderFeature::TESSELLATION)) {
+    return _buildTessellationProgram(variant);
+  }
+
+  // The shadow caster shares the sphere vertex source, so both passes decode the vertex formats alike
+  if (variant.has(ShaderFeature::SHADOW_CASTER)) {
+    return _buildProgram(withDefines(_vertexSource, variant), GeneratedShaders::SHADOW_FRAGMENT_SHADER);
+  }
+
+  // Precompiled SPIR-V skips the driver's GLSL front end; without it, or when it fails, compile the source.
+  // It was compiled from the embedded sources, so it is stale once they are replaced by files.
+  if (!_sourcesFromFiles) {
+    unsigned int program = _buildSpirvVariant(variant);
+    if (program != 0) {
+      return program;
+    }
+  }
+
+  // Vertex pulling generates its vertices, everything else shares the sphere vertex shader
+  if (variant.has(ShaderFeature::VERTEX_PULLING)) {
+    return _buildProgram(withDefines(GeneratedShaders::PULLING_VERTEX_SHADER, variant), withDefines(_fragmentSource, variant));
+  }
+  return _buildProgram(withDefines(_vertexSource, variant), withDefines(_fragmentSource, variant));
+}
+
+std::string ShaderManager::withDefines(const std::string& source, ShaderVariant variant) {
+  std::string defines;
+  for (const ShaderFeatureDefine& feature : SHADER_FEATURE_DEFINES) {
+    if (variant.has(feature.feature)) {
+      defines += "#define ";
+      defines += feature.define;
+      defines += '\n';
+    }
+  }
+  if (defines.empty()) {
+    return source;
+  }
+
+  // Defines must follow the #version line
+  size_t lineEnd = source.find('\n');
+  if (lineEnd == std::string::npos) {
+    return source;
+  }
+  return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+unsigned int ShaderManager::getProgram(ShaderVariant variant) const {
+  return _getProgramEntry(variant).id;
+}
+
+const ShaderManager::Program& ShaderManager::_getProgramEntry(ShaderVariant variant) const {
+  auto found = _programs.find(variant.getBits());
+  if (found != _programs.end()) {
+    return found->second;
+  }
+
+  // Failures are cached too, so a broken variant is reported once rather than every frame
+  Program program;
+  program.id = _buildVariant(variant);
+  program.fixedLocations = !_sourcesFromFiles;
+  if (program.id == 0) {
+    std::cerr << "Failed to build shader variant 0x" << std::hex << variant.getBits() << std::dec << std::endl;
+  }
+  return _programs.emplace(variant.getBits(), program).first->second;
+}
+
+unsigned int ShaderManager::getProgram(RenderMethod method, InstanceDataSource source, VertexFormat format) const {
+  return getProgram(sphereShaderVariant(method, source, format));
+}
@@ -1,19 +1,32 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
+#include "InstanceDataSource.h"
 #include "RenderMethod.h"
+#include "ShaderVariant.h"
+#include "VertexFormat.h"
 
+// Sphere programs are permutations of one vertex and one fragment source, keyed by ShaderVariant.
+// A variant is compiled the first time it is used and cached, failures included, until cleanup.
+// Variants come from embedded SPIR-V where the driver takes it, otherwise from the GLSL sources;
+// the tessellation and shadow caster variants are always compiled from GLSL.
+// loadShaders swaps the sphere sources for files, after which every variant is compiled from them.
 class ShaderManager {
 public:
   ShaderManager();
   ~ShaderManager();
 
   // Shader management
+  // Replaces the sphere vertex and fragment sources and drops every cached variant, so each one is
+  // rebuilt from the files on its next use. Nothing changes when the default variant fails to build.
   bool loadShaders(const std::string& vertexPath, const std::string& fragmentPath);
   bool loadEmbeddedShaders();
-  bool loadMultiDrawShaders();
-  void useProgram(RenderMethod method = RenderMethod::INSTANCED) const;
+  void useProgram(RenderMethod method = RenderMethod::INSTANCED, InstanceDataSource source = InstanceDataSource::SSBO,
+                  VertexFormat format = VertexFormat::FLOAT32) const;
+  void useProgram(ShaderVariant variant) const;
   void cleanup();
 
   // Uniform setters
@@ -21,16 +34,37 @@ public:
   void setFloat(const std::string& name, float value) const;
   void setInt(const std::string& name, int value) const;
   void setVec3(const std::string& name, const glm::vec3& vector) const;
+  void setMatrix4Array(const std::string& name, const glm::mat4* matrices, int count) const;
 
-  // Getters
-  unsigned int getProgram(RenderMethod method = RenderMethod::INSTANCED) const;
+  // Source with one #define per feature of the variant inserted after the #version line
+  static std::string withDefines(const std::string& source, ShaderVariant variant);
+
+  // Getters, compiling the variant on first use; 0 when it failed to build
+  unsigned int getProgram(ShaderVariant variant) const;
+  unsigned int getProgram(RenderMethod method, InstanceDataSource source = InstanceDataSource::SSBO, VertexFormat format = VertexFormat::FLOAT32) const;
+  size_t getCompiledVariantCount() const {
+    return _programs.size();
+  }
 
 private:
-  unsigned int _instancedProgram;
-  unsigned int _multiDrawProgram;
-  mutable RenderMethod _currentMethod = RenderMethod::INSTANCED;
+  struct Program {
+    unsigned int id = 0;
+    bool fixedLocations = true;  // Uniforms at SPHERE_UNIFORMS, false for programs built from files
+  };
+
+  mutable std::unordered_map<uint32_t, Program> _programs;  // By variant bits
+  mutable ShaderVariant _currentVariant;
+
+  // Sphere sources every variant is built from, the embedded ones unless loaded from files
+  std::string _vertexSource;
+  std::string _fragmentSource;
+  bool _sourcesFromFiles;
 
   // Helper methods
   int _getUniformLocation(const std::string& name) const;
-  unsigned int _getCurrentProgram() const;
-};
\ No newline at end of file
+  const Program& _getProgramEntry(ShaderVariant variant) const;
+  static unsigned int _buildProgram(const std::string& vertexSource, const std::string& fragmentSource);
+  unsigned int _buildTessellationProgram(ShaderVariant variant) const;
+  static unsigned int _buildSpirvVariant(ShaderVariant variant);
+  unsigned int _buildVariant(ShaderVariant variant) const;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "InstanceDataSource.h"
+#include "RenderMethod.h"
+#include "VertexFormat.h"
+
+// Compile-time options of the sphere shaders, each one a #define injected after the #version line
+enum class ShaderFeature : uint32_t {
+  VERTEX_SNORM16 = 1u << 0,      // snorm16 unit positions scaled by sphereRadius
+  VERTEX_OCTAHEDRAL = 1u << 1,   // snorm16 octahedral directions scaled by sphereRadius
+  DRAW_ID = 1u << 2,             // Visible index from firstDraw + gl_DrawID instead of the instance
+  INSTANCE_ATTRIBUTE = 1u << 3,  // Matrix from divisor attributes, in buffer order
+  INSTANCE_TEXELS = 1u << 4,     // Matrix from a texture buffer instead of the SSBO
+  VERTEX_PULLING = 1u << 5,      // Sphere generated from gl_VertexID, no vertex attributes
+  TESSELLATION = 1u << 6,        // Octahedron from gl_VertexID refined by the tessellation stages
+  SHADOW_CASTER = 1u << 7,       // Depth only, every instance once per shadow cascade routed with gl_Layer
+};
+
+struct ShaderFeatureDefine {
+  ShaderFeature feature;
+  const char* define;
+};
+
+constexpr ShaderFeatureDefine SHADER_FEATURE_DEFINES[] = {
+    {ShaderFeature::VERTEX_SNORM16, "VERTEX_FORMAT_SNORM16"}, {ShaderFeature::VERTEX_OCTAHEDRAL, "VERTEX_FORMAT_OCTAHEDRAL"},
+    {ShaderFeature::DRAW_ID, "DRAW_ID"},                      {ShaderFeature::INSTANCE_ATTRIBUTE, "INSTANCE_ATTRIBUTE"},
+    {ShaderFeature::INSTANCE_TEXELS, "INSTANCE_TEXELS"},      {ShaderFeature::VERTEX_PULLING, "VERTEX_PULLING"},
+    {ShaderFeature::TESSELLATION, "TESSELLATION"},        {ShaderFeature::SHADOW_CASTER, "SHADOW_CASTER"},
+};
+
+// Set of features naming one compiled program; the bits are the cache key
+class ShaderVariant {
+public:
+  constexpr ShaderVariant() : _bits(0) {}
+  constexpr ShaderVariant(ShaderFeature feature) : _bits(static_cast<uint32_t>(feature)) {}
+
+  constexpr ShaderVariant operator|(ShaderVariant other) const {
+    return fromBits(_bits | other._bits);
+  }
+  constexpr bool operator==(ShaderVariant other) const {
+    return _bits == other._bits;
+  }
+  constexpr bool operator!=(ShaderVariant other) const {
+    return _bits != other._bits;
+  }
+
+  constexpr bool has(ShaderFeature feature) const {
+    return (_bits & static_cast<uint32_t>(feature)) != 0;
+  }
+  constexpr uint32_t getBits() const {
+    return _bits;
+  }
+  static constexpr ShaderVariant fromBits(uint32_t bits) {
+    ShaderVariant variant;
+    variant._bits = bits;
+    return variant;
+  }
+
+private:
+  uint32_t _bits;
+};
+
+constexpr ShaderVariant operator|(ShaderFeature a, ShaderFeature b) {
+  return ShaderVariant(a) | ShaderVariant(b);
+}
+
+constexpr ShaderVariant vertexFormatVariant(VertexFormat format) {
+  switch (format) {
+    case VertexFormat::SNORM16:
+      return ShaderFeature::VERTEX_SNORM16;
+    case VertexFormat::OCTAHEDRAL:
+      return ShaderFeature::VERTEX_OCTAHEDRAL;
+    default:
+      return ShaderVariant();
+  }
+}
+
+// Variant drawing the shadow map with the same vertex layout and decode as the main pass
+constexpr ShaderVariant shadowCasterVariant(VertexFormat format) {
+  return vertexFormatVariant(format) | ShaderFeature::SHADOW_CASTER;
+}
+
+// Variant drawing spheres with a render method; unsupported sources fall back to the SSBO
+constexpr ShaderVariant sphereShaderVariant(RenderMethod method, InstanceDataSource source, VertexFormat format) {
+  if (method == RenderMethod::VERTEX_PULLING) {
+    return ShaderFeature::VERTEX_PULLING;
+  }
+  if (method == RenderMethod::TESSELLATION) {
+    return ShaderFeature::TESSELLATION;
+  }
+
+  ShaderVariant variant = vertexFormatVariant(format);
+  if (method == RenderMethod::MULTIDRAW) {
+    variant = variant | ShaderFeature::DRAW_ID;
+  }
+  if (isInstanceDataSourceSupported(method, source)) {
+    if (source == InstanceDataSource::VERTEX_ATTRIBUTE) {
+      variant = variant | ShaderFeature::INSTANCE_ATTRIBUTE;
+    } else if (source == InstanceDataSource::TEXTURE_BUFFER) {
+      variant = variant | ShaderFeature::INSTANCE_TEXELS;
+    }
+  }
+  return variant;
+}
+
+// Variant an embedded SPIR-V module was compiled for, from its space-separated defines
+inline ShaderVariant variantFromDefines(const std::string& defines) {
+  ShaderVariant variant;
+  size_t start = 0;
+  while (start < defines.size()) {
+    size_t end = defines.find(' ', start);
+    if (end == std::string::npos) {
+      end = defines.size();
+    }
+    std::string define = defines.substr(start, end - start);
+    for (const ShaderFeatureDefine& feature : SHADER_FEATURE_DEFINES) {
+      if (define == feature.define) {
+        variant = variant | feature.feature;
+      }
+    }
+    start = end + 1;
+  }
+  return variant;
+}
+
+// Uniforms of the sphere programs at the locations the sphere sources declare. SPIR-V programs
+// cannot be queried by name, so every embedded variant is addressed through this table.
+struct SphereUniform {
+  const char* name;
+  int location;
+};
+
+constexpr SphereUniform SPHERE_UNIFORMS[] = {
+    {"view", 0},           {"projection", 1}, {"sphereRadius", 2},   {"firstDraw", 3},      {"sphereSegments", 4},
+    {"instanceTexels", 5}, {"shadowMap", 6},  {"shadowCascades", 7}, {"shadowMatrices", 8}, {"viewportHeight", 12},
+    {"tessellationError", 13}, {"cascadeMatrices", 14}, {"cascadeCount", 18},
+};
@@ -0,0 +1,160 @@
+#include "ShadowMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Camera.h"
+#include "GLStateCache.h"
+#include "ShaderManager.h"
+
+namespace {
+// Blend between logarithmic (1) and uniform (0) cascade splits
+const float SPLIT_LAMBDA = 0.75f;
+
+// Casters up to this far behind a cascade along the light still land in it (depth clamp keeps closer ones)
+const float CASTER_MARGIN = 10.0f;
+
+// Slope-scaled depth bias against self-shadowing
+const float POLYGON_OFFSET_FACTOR = 2.0f;
+const float POLYGON_OFFSET_UNITS = 4.0f;
+}  // namespace
+
+ShadowMap::ShadowMap() : _texture(0), _framebuffer(0) {}
+
+ShadowMap::~ShadowMap() {
+  cleanup();
+}
+
+bool ShadowMap::initialize() {
+  if (!GLEW_ARB_shader_viewport_layer_array && !GLEW_AMD_vertex_shader_layer) {
+    std::cerr << "gl_Layer is not writable from vertex shaders, cascaded shadows disabled" << std::endl;
+    return false;
+  }
+
+  // Hardware depth comparison with linear filtering gives 2x2 PCF per lookup
+  glGenTextures(1, &_texture);
+  GLStateCache::bindTexture(0, GL_TEXTURE_2D_ARRAY, _texture);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, RESOLUTION, RESOLUTION, MAX_CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  GLStateCache::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+
+  // Layered attachment: gl_Layer selects the cascade
+  glGenFramebuffers(1, &_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, _texture, 0);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Shadow map framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+    cleanup();
+    return false;
+  }
+
+  return true;
+}
+
+void ShadowMap::cleanup() {
+  if (_framebuffer != 0) {
+    glDeleteFramebuffers(1, &_framebuffer);
+    _framebuffer = 0;
+  }
+  if (_texture != 0) {
+    GLStateCache::deleteTexture(_texture);
+    _texture = 0;
+  }
+}
+
+void ShadowMap::update(const Camera& camera, const glm::vec3& lightDirection, float maxDistance) {
+  float nearPlane = camera.getNearPlane();
+  float farPlane = std::max(nearPlane * 2.0f, std::min(camera.getFarPlane(), maxDistance));
+  float tanHalfFov = std::tan(glm::radians(camera.getFov()) * 0.5f);
+  glm::mat4 inverseView = glm::inverse(camera.getViewMatrix());
+
+  // Light basis, up must not be parallel to the light
+  glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+  float sliceNear = nearPlane;
+  for (int cascade = 0; cascade < MAX_CASCADES; ++cascade) {
+    // Practical split scheme: logarithmic near the camera, uniform further out
+    float fraction = static_cast<float>(cascade + 1) / MAX_CASCADES;
+    float logSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+    float uniformSplit = nearPlane + (farPlane - nearPlane) * fraction;
+    float sliceFar = SPLIT_LAMBDA * logSplit + (1.0f - SPLIT_LAMBDA) * uniformSplit;
+
+    // Bounding sphere of the slice's eight corners, its size does not change as the camera turns
+    glm::vec3 corners[8];
+    int corner = 0;
+    for (float depth : {sliceNear, sliceFar}) {
+      float halfHeight = depth * tanHalfFov;
+      float halfWidth = halfHeight * camera.getAspectRatio();
+      for (float x : {-halfWidth, halfWidth}) {
+        for (float y : {-halfHeight, halfHeight}) {
+          corners[corner++] = glm::vec3(inverseView * glm::vec4(x, y, -depth, 1.0f));
+        }
+      }
+    }
+    glm::vec3 center(0.0f);
+    for (const glm::vec3& point : corners) {
+      center += point;
+    }
+    center /= 8.0f;
+    float radius = 0.0f;
+    for (const glm::vec3& point : corners) {
+      radius = std::max(radius, glm::length(point - center));
+    }
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    glm::mat4 lightView = glm::lookAt(center + lightDirection * (radius + CASTER_MARGIN), center, up);
+    glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + CASTER_MARGIN);
+
+    // Snap the origin to whole texels so shadow edges do not shimmer as the camera moves
+    glm::mat4 lightMatrix = lightProjection * lightView;
+    glm::vec4 origin = lightMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float texelsPerUnit = RESOLUTION * 0.5f;
+    lightProjection[3][0] += std::round(origin.x * texelsPerUnit) / texelsPerUnit - origin.x;
+    lightProjection[3][1] += std::round(origin.y * texelsPerUnit) / texelsPerUnit - origin.y;
+
+    _cascadeMatrices[cascade] = lightProjection * lightView;
+    sliceNear = sliceFar;
+  }
+}
+
+bool ShadowMap::begin(const ShaderManager& shaderManager, VertexFormat format, float sphereRadius) {
+  // Built on first use by the shader manager; without it the map would never be written, so shadows go off
+  ShaderVariant variant = shadowCasterVariant(format);
+  if (shaderManager.getProgram(variant) == 0) {
+    std::cerr << "No shadow caster program for " << VERTEX_FORMAT_NAMES[static_cast<int>(format)] << ", cascaded shadows disabled" << std::endl;
+    cleanup();
+    return false;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+  glViewport(0, 0, RESOLUTION, RESOLUTION);
+  glClear(GL_DEPTH_BUFFER_BIT);
+
+  // Casters between the light and a cascade's near plane are clamped instead of clipped
+  glEnable(GL_DEPTH_CLAMP);
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+
+  shaderManager.useProgram(variant);
+  shaderManager.setMatrix4Array("cascadeMatrices", _cascadeMatrices, MAX_CASCADES);
+  shaderManager.setInt("cascadeCount", MAX_CASCADES);
+  shaderManager.setFloat("sphereRadius", sphereRadius);
+  return true;
+}
+
+void ShadowMap::end() {
+  glDisable(GL_POLYGON_OFFSET_FILL);
+  glDisable(GL_DEPTH_CLAMP);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
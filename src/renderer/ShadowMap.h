@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "VertexFormat.h"
+
+class Camera;
+class ShaderManager;
+
+// Directional light cascaded shadow map rendered in a single submission.
+// Every cascade is a layer of one depth texture array; the shadow caster variant of the sphere program
+// draws each instance once per cascade (instance = sphere * cascadeCount + cascade) and routes it with
+// gl_Layer from the vertex shader, reading the same InstanceMatrices SSBO as the main pass. Needs
+// ARB_shader_viewport_layer_array or AMD_vertex_shader_layer, shadows stay off without them.
+class ShadowMap {
+public:
+  static const int MAX_CASCADES = 4;
+  static const int RESOLUTION = 2048;
+
+  ShadowMap();
+  ~ShadowMap();
+
+  bool initialize();
+  void cleanup();
+  bool isAvailable() const {
+    return _texture != 0;
+  }
+
+  // Fits the cascades to the camera frustum, split between its near plane and maxDistance
+  void update(const Camera& camera, const glm::vec3& lightDirection, float maxDistance);
+
+  // Binds the layered framebuffer and the shadow caster program for the vertex format, clears all layers.
+  // False, with nothing bound and the map cleaned up, when the program failed to build.
+  bool begin(const ShaderManager& shaderManager, VertexFormat format, float sphereRadius);
+  // Restores the default framebuffer and rasterizer state
+  void end();
+
+  GLuint getTexture() const {
+    return _texture;
+  }
+  int getCascadeCount() const {
+    return MAX_CASCADES;
+  }
+  const glm::mat4* getCascadeMatrices() const {
+    return _cascadeMatrices;
+  }
+
+private:
+  GLuint _texture;
+  GLuint _framebuffer;
+  glm::mat4 _cascadeMatrices[MAX_CASCADES];
+};
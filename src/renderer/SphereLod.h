@@ -0,0 +1,11 @@
+#pragma once
+
+const int MAX_SPHERE_LODS = 3;
+
+// One level of detail inside the shared sphere VBO/EBO
+struct SphereLod {
+  int segments = 0;  // UV segments; other topologies match their silhouette error
+  unsigned int firstIndex = 0;  // In indices, not bytes
+  unsigned int indexCount = 0;
+  int baseVertex = 0;
+};
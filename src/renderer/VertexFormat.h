@@ -0,0 +1,22 @@
+#pragma once
+
+// Sphere vertex layouts in the VBO
+// - FLOAT32: float position and normal, 24 bytes
+// - SNORM16: snorm16 unit position (padded to 4 components), normal derived in the shader, 8 bytes
+// - OCTAHEDRAL: snorm16 octahedral-encoded unit direction, position = direction * radius, 4 bytes
+enum class VertexFormat { FLOAT32 = 0, SNORM16 = 1, OCTAHEDRAL = 2 };
+
+const char* const VERTEX_FORMAT_NAMES[] = {"Float32 (24 B)", "Snorm16 Position (8 B)", "Octahedral (4 B)"};
+
+const int VERTEX_FORMAT_COUNT = sizeof(VERTEX_FORMAT_NAMES) / sizeof(VERTEX_FORMAT_NAMES[0]);
+
+inline unsigned int getVertexStride(VertexFormat format) {
+  switch (format) {
+    case VertexFormat::SNORM16:
+      return 8;
+    case VertexFormat::OCTAHEDRAL:
+      return 4;
+    default:
+      return 24;
+  }
+}
@@ -0,0 +1,54 @@
+#version 460 core
+
+// No vertex attributes: the sphere is generated from gl_VertexID
+
+// SSBO for instance matrices
+layout(std430, binding = 0) buffer InstanceMatrices {
+  mat4 instanceMatrix[];
+};
+
+// Visible instance indices, grouped by LOD and optionally depth sorted
+layout(std430, binding = 1) readonly buffer InstanceIndices {
+  uint instanceIndex[];
+};
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragPosition;
+
+// Locations shared with sphere.vert, see SPHERE_UNIFORMS
+layout(location = 0) uniform mat4 view;
+layout(location = 1) uniform mat4 projection;
+layout(location = 2) uniform float sphereRadius;
+layout(location = 4) uniform int sphereSegments;
+
+const float PI = 3.14159265358979323846;
+
+// (ring, sector) offsets of the two triangles of a quad, same winding as Sphere::generateSphere
+const ivec2 QUAD_CORNERS[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(1, 1), ivec2(0, 0), ivec2(1, 1), ivec2(0, 1));
+
+void main() {
+  int rings = sphereSegments;
+  int sectors = sphereSegments * 2;
+
+  // Locate the quad and the corner this vertex belongs to
+  int quad = gl_VertexID / 6;
+  ivec2 corner = QUAD_CORNERS[gl_VertexID % 6];
+  int r = quad / (sectors - 1) + corner.x;
+  int s = quad % (sectors - 1) + corner.y;
+
+  // Same parametrization as the CPU generator
+  float phi = PI * float(r) / float(rings - 1);
+  float theta = 2.0 * PI * float(s) / float(sectors - 1);
+  vec3 unitPosition = vec3(cos(theta) * sin(phi), sin(-PI / 2.0 + phi), sin(theta) * sin(phi));
+
+  // Get instance matrix, gl_BaseInstance selects the LOD range of the visible list
+  mat4 modelMatrix = instanceMatrix[instanceIndex[gl_BaseInstance + gl_InstanceID]];
+
+  // Transform position
+  vec4 worldPos = modelMatrix * vec4(unitPosition * sphereRadius, 1.0);
+  gl_Position = projection * view * worldPos;
+
+  // Pass data to fragment shader (normal of a unit sphere is its position)
+  fragPosition = worldPos.xyz;
+  fragNormal = mat3(modelMatrix) * unitPosition;
+}
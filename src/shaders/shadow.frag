@@ -0,0 +1,5 @@
+#version 460 core
+
+// Depth only, the fixed-function depth write is all the shadow pass needs
+void main() {
+}
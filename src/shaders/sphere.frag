@@ -0,0 +1,46 @@
+#version 460 core
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec3 fragPosition;
+
+layout(location = 0) out vec4 fragColor;
+
+// Cascaded shadow map, rendered in one pass by the shadow program (shadowCascades is 0 when off)
+layout(location = 6, binding = 1) uniform sampler2DArrayShadow shadowMap;
+layout(location = 7) uniform int shadowCascades;
+layout(location = 8) uniform mat4 shadowMatrices[4];  // Locations 8-11
+
+// Fraction of the light reaching a point, from the first cascade containing it
+float shadowFactor(vec3 worldPosition) {
+  for (int cascade = 0; cascade < shadowCascades; ++cascade) {
+    vec4 clip = shadowMatrices[cascade] * vec4(worldPosition, 1.0);
+    vec3 coord = clip.xyz / clip.w * 0.5 + 0.5;
+    if (all(greaterThanEqual(coord.xy, vec2(0.0))) && all(lessThanEqual(coord.xy, vec2(1.0))) && coord.z <= 1.0) {
+      return texture(shadowMap, vec4(coord.xy, float(cascade), coord.z));
+    }
+  }
+  return 1.0;
+}
+
+void main() {
+  // Normalize the normal
+  vec3 normal = normalize(fragNormal);
+
+  // Simple lighting calculation
+  vec3 lightDir = normalize(vec3(1.0, 1.0, 1.0));
+  float diff = max(dot(normal, lightDir), 0.0) * shadowFactor(fragPosition);
+
+  // Create a color based on position for visual variety, multidraw gets its own tint
+#if defined(DRAW_ID)
+  vec3 baseColor = vec3(0.8, 0.6, 1.0);
+#else
+  vec3 baseColor = vec3(0.6, 0.8, 1.0);
+#endif
+  vec3 color = baseColor * (0.3 + 0.7 * diff);
+
+  // Add some color variation based on position
+  color += sin(fragPosition.x * 5.0) * 0.1;
+  color += sin(fragPosition.z * 5.0) * 0.1;
+
+  fragColor = vec4(color, 1.0);
+}
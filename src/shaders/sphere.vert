@@ -0,0 +1,143 @@
+#version 460 core
+#if defined(SHADOW_CASTER)
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+#endif
+
+// One source for every sphere variant, the shader manager prepends the ShaderFeature defines:
+// VERTEX_FORMAT_SNORM16, VERTEX_FORMAT_OCTAHEDRAL, DRAW_ID, INSTANCE_ATTRIBUTE, INSTANCE_TEXELS, SHADOW_CASTER.
+// Uniforms and varyings have explicit locations, SPIR-V builds match them by location only (SPHERE_UNIFORMS)
+
+// Vertex layout
+#if defined(VERTEX_FORMAT_OCTAHEDRAL)
+layout(location = 0) in vec2 vertexDirection;  // snorm16 octahedral unit direction
+#elif defined(VERTEX_FORMAT_SNORM16)
+layout(location = 0) in vec3 vertexDirection;  // snorm16 unit position
+#else
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+#endif
+
+#if defined(VERTEX_FORMAT_OCTAHEDRAL) || defined(VERTEX_FORMAT_SNORM16) || defined(SHADOW_CASTER)
+layout(location = 2) uniform float sphereRadius;
+#endif
+
+#if defined(SHADOW_CASTER)
+// Every instance, not the camera's visible list: casters outside the view still cast
+layout(std430, binding = 0) readonly buffer InstanceMatrices {
+  mat4 instanceMatrix[];
+};
+
+const int MAX_CASCADES = 4;
+
+layout(location = 14) uniform mat4 cascadeMatrices[MAX_CASCADES];  // Light view-projection per cascade, locations 14-17
+layout(location = 18) uniform int cascadeCount;
+#elif defined(INSTANCE_ATTRIBUTE)
+// Instance matrix from the instance buffer, advanced once per instance (divisor 1, locations 2-5).
+// Attributes are fetched in buffer order, so this variant ignores the depth-sorted draw order.
+layout(location = 2) in mat4 instanceMatrix;
+#else
+#if defined(INSTANCE_TEXELS)
+// Instance matrices as RGBA32F texels, four columns per instance
+layout(location = 5, binding = 0) uniform samplerBuffer instanceTexels;
+#else
+// SSBO for instance matrices
+layout(std430, binding = 0) buffer InstanceMatrices {
+  mat4 instanceMatrix[];
+};
+#endif
+
+// Visible instance indices, grouped by LOD and optionally depth sorted
+layout(std430, binding = 1) readonly buffer InstanceIndices {
+  uint instanceIndex[];
+};
+#endif
+
+#if !defined(SHADOW_CASTER)
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragPosition;
+#endif
+
+layout(location = 0) uniform mat4 view;
+layout(location = 1) uniform mat4 projection;
+#if defined(DRAW_ID)
+layout(location = 3) uniform int firstDraw;  // Visible index of the call's first draw, gl_DrawID restarts per call
+#endif
+
+// Object-space position and normal; on a sphere the normal is the unit position
+void decodeVertex(out vec3 position, out vec3 normal) {
+#if defined(VERTEX_FORMAT_OCTAHEDRAL)
+  vec3 direction = vec3(vertexDirection, 1.0 - abs(vertexDirection.x) - abs(vertexDirection.y));
+  if (direction.z < 0.0) {
+    vec2 signs = vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+    direction.xy = (1.0 - abs(direction.yx)) * signs;
+  }
+  normal = normalize(direction);
+  position = normal * sphereRadius;
+#elif defined(VERTEX_FORMAT_SNORM16)
+  normal = normalize(vertexDirection);
+  position = vertexDirection * sphereRadius;
+#else
+  position = vertexPosition;
+  normal = vertexNormal;
+#endif
+}
+
+#if defined(SHADOW_CASTER)
+void main() {
+  vec3 position;
+  vec3 normal;
+  decodeVertex(position, normal);
+
+  // One instance per sphere and cascade, the cascade picks the array layer
+  int cascade = gl_InstanceID % cascadeCount;
+  mat4 modelMatrix = instanceMatrix[gl_InstanceID / cascadeCount];
+  mat4 cascadeMatrix = cascadeMatrices[cascade];
+  gl_Layer = cascade;
+
+  // Spheres outside the cascade's box are moved off screen so the rasterizer skips them
+  vec4 center = cascadeMatrix * modelMatrix[3];
+  float radius = sphereRadius * length(modelMatrix[0].xyz) * length(cascadeMatrix[0].xyz);
+  if (any(greaterThan(abs(center.xy), vec2(1.0 + radius)))) {
+    gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+    return;
+  }
+
+  gl_Position = cascadeMatrix * (modelMatrix * vec4(position, 1.0));
+}
+#else
+mat4 fetchModelMatrix() {
+#if defined(INSTANCE_ATTRIBUTE)
+  return instanceMatrix;
+#else
+#if defined(DRAW_ID)
+  int visible = firstDraw + gl_DrawID;
+#else
+  // gl_BaseInstance selects the LOD range of the visible list
+  int visible = gl_BaseInstance + gl_InstanceID;
+#endif
+#if defined(INSTANCE_TEXELS)
+  int base = int(instanceIndex[visible]) * 4;
+  return mat4(texelFetch(instanceTexels, base), texelFetch(instanceTexels, base + 1), texelFetch(instanceTexels, base + 2), texelFetch(instanceTexels, base + 3));
+#else
+  return instanceMatrix[instanceIndex[visible]];
+#endif
+#endif
+}
+
+void main() {
+  vec3 position;
+  vec3 normal;
+  decodeVertex(position, normal);
+
+  mat4 modelMatrix = fetchModelMatrix();
+
+  // Transform position
+  vec4 worldPos = modelMatrix * vec4(position, 1.0);
+  gl_Position = projection * view * worldPos;
+
+  // Pass data to fragment shader
+  fragPosition = worldPos.xyz;
+  fragNormal = mat3(modelMatrix) * normal;
+}
+#endif
@@ -0,0 +1,24 @@
+#version 460 core
+
+// No vertex attributes: the corners of the base octahedron come from gl_VertexID, three per patch.
+// The control shader refines each face to the detail the sphere needs on screen.
+
+// Visible instance indices, grouped by LOD and optionally depth sorted
+layout(std430, binding = 1) readonly buffer InstanceIndices {
+  uint instanceIndex[];
+};
+
+layout(location = 0) out vec3 controlDirection;
+layout(location = 1) flat out uint controlInstance;
+
+// Faces wound outward like Sphere::generateOctasphere
+const vec3 OCTAHEDRON_CORNERS[6] =
+    vec3[6](vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+const int OCTAHEDRON_FACES[24] = int[24](4, 0, 2, 0, 5, 2, 5, 1, 2, 1, 4, 2, 0, 4, 3, 5, 0, 3, 1, 5, 3, 4, 1, 3);
+
+void main() {
+  controlDirection = OCTAHEDRON_CORNERS[OCTAHEDRON_FACES[gl_VertexID]];
+
+  // gl_BaseInstance is the start of the visible list, every visible sphere is drawn at once
+  controlInstance = instanceIndex[gl_BaseInstance + gl_InstanceID];
+}
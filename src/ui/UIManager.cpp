@@ -3,7 +3,18 @@
 #include <GLFW/glfw3.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
-#include "../geo/Sphere.h"
+#include "../renderer/ClusterCuller.h"
+#include "../renderer/QualityController.h"
+#include "../utils/Profiler.h"
+
+UIDrawSnapshot::UIDrawSnapshot() : drawData(IM_NEW(ImDrawData)()) {}
+
+UIDrawSnapshot::~UIDrawSnapshot() {
+  for (ImDrawList* drawList : drawData->CmdLists) {
+    IM_DELETE(drawList);
+  }
+  IM_DELETE(drawData);
+}
 
 UIManager::UIManager() : _window(nullptr) {}
 
@@ -24,6 +35,10 @@ bool UIManager::initialize(GLFWwindow* win) {
   ImGui_ImplGlfw_InitForOpenGL(_window, true);
   ImGui_ImplOpenGL3_Init("#version 330");
 
+  // Builds the font atlas and the backend's GL objects now, so ImGui_ImplOpenGL3_NewFrame has no GL work
+  // left and can run on the input thread with the rest of the frame
+  ImGui_ImplOpenGL3_CreateDeviceObjects();
+
   return true;
 }
 
@@ -34,24 +49,70 @@ void UIManager::cleanup() {
 }
 
 void UIManager::newFrame() {
+  PROFILE_ZONE("UIManager::newFrame");
+
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
 }
 
 void UIManager::render() {
+  PROFILE_ZONE("UIManager::render");
+
   if (_uiState.showUI) {
+    PROFILE_ZONE("UIManager::buildControlPanel");
     _renderControlPanel();
   }
 
   // Render ImGui
+  {
+    PROFILE_ZONE("ImGui::Render");
+    ImGui::Render();
+  }
+  {
+    PROFILE_ZONE("ImGui_ImplOpenGL3_RenderDrawData");
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
+}
+
+void UIManager::buildFrame(UIDrawSnapshot& snapshot) {
+  PROFILE_ZONE("UIManager::buildFrame");
+
+  // Every ImGui call stays on this thread, the render thread only draws the copy below.
+  // The backend objects were created in initialize, so the OpenGL backend's NewFrame issues no GL calls.
+  ImGui_ImplOpenGL3_NewFrame();
+  ImGui_ImplGlfw_NewFrame();
+  ImGui::NewFrame();
+
+  if (_uiState.showUI) {
+    PROFILE_ZONE("UIManager::buildControlPanel");
+    _renderControlPanel();
+  }
   ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+  // Clone the draw lists, the next NewFrame reuses ImGui's own
+  ImDrawData* source = ImGui::GetDrawData();
+  ImDrawData* target = snapshot.drawData;
+  for (ImDrawList* drawList : target->CmdLists) {
+    IM_DELETE(drawList);
+  }
+  target->Clear();
+  target->Valid = source->Valid;
+  target->DisplayPos = source->DisplayPos;
+  target->DisplaySize = source->DisplaySize;
+  target->FramebufferScale = source->FramebufferScale;
+  for (ImDrawList* drawList : source->CmdLists) {
+    target->AddDrawList(drawList->CloneOutput());
+  }
 }
 
-void UIManager::updatePerformanceInfo(const SphereGeometry& geometry, int instanceCount) {
-  _uiState.vertexCount = geometry.vertexCount * instanceCount;
-  _uiState.triangleCount = (geometry.indexCount / 3) * instanceCount;
+void UIManager::renderDrawData(const UIDrawSnapshot& snapshot) {
+  PROFILE_ZONE("UIManager::renderDrawData");
+
+  // Reads only the copy and the backend's GL objects, never the ImGui state the input thread is updating
+  if (snapshot.drawData->Valid) {
+    ImGui_ImplOpenGL3_RenderDrawData(snapshot.drawData);
+  }
 }
 
 void UIManager::_renderControlPanel() {
@@ -61,13 +122,54 @@ void UIManager::_renderControlPanel() {
   RenderMethod oldRenderMethod = _uiState.renderMethod;
   int currentMethodIndex = static_cast<int>(_uiState.renderMethod);
 
-  if (ImGui::Combo("Rendering Method", &currentMethodIndex, RENDER_METHOD_NAMES, 3)) {
+  if (ImGui::Combo("Rendering Method", &currentMethodIndex, RENDER_METHOD_NAMES, IM_ARRAYSIZE(RENDER_METHOD_NAMES))) {
     _uiState.renderMethod = static_cast<RenderMethod>(currentMethodIndex);
     if (_uiState.renderMethod != oldRenderMethod && _onRenderMethodChanged) {
       _onRenderMethodChanged(_uiState.renderMethod);
     }
   }
 
+  // Instance data source selection
+  int currentSourceIndex = static_cast<int>(_uiState.instanceDataSource);
+
+  if (ImGui::Combo("Instance Data", &currentSourceIndex, INSTANCE_DATA_SOURCE_NAMES, IM_ARRAYSIZE(INSTANCE_DATA_SOURCE_NAMES))) {
+    _uiState.instanceDataSource = static_cast<InstanceDataSource>(currentSourceIndex);
+    if (_onInstanceDataSourceChanged) {
+      _onInstanceDataSourceChanged(_uiState.instanceDataSource);
+    }
+  }
+
+  if (!isInstanceDataSourceSupported(_uiState.renderMethod, _uiState.instanceDataSource)) {
+    ImGui::TextDisabled("Not supported by this method, using SSBO");
+  }
+
+  // Depth sort selection
+  int currentSortIndex = static_cast<int>(_uiState.depthSortMode);
+  if (ImGui::Combo("Depth Sort", &currentSortIndex, DEPTH_SORT_MODE_NAMES, IM_ARRAYSIZE(DEPTH_SORT_MODE_NAMES))) {
+    _uiState.depthSortMode = static_cast<DepthSortMode>(currentSortIndex);
+  }
+  if (_uiState.depthSortMode != DepthSortMode::NONE && _uiState.instanceDataSource == InstanceDataSource::VERTEX_ATTRIBUTE &&
+      isInstanceDataSourceSupported(_uiState.renderMethod, _uiState.instanceDataSource)) {
+    ImGui::TextDisabled("Vertex attributes are fetched in buffer order, sort has no effect");
+  }
+
+  // Frame preparation
+  ImGui::Checkbox("Pipelined Frames", &_uiState.pipelinedFrames);
+  ImGui::Checkbox("Frustum Culling", &_uiState.frustumCulling);
+  ImGui::Checkbox("Distance LOD", &_uiState.lodSelection);
+  if (_uiState.lodSelection || _uiState.adaptiveQuality) {
+    ImGui::SliderFloat("LOD Bias", &_uiState.lodBias, -2.0f, 2.0f, "%.1f");
+  }
+  if ((_uiState.frustumCulling || _uiState.lodSelection) && _uiState.instanceDataSource == InstanceDataSource::VERTEX_ATTRIBUTE &&
+      isInstanceDataSourceSupported(_uiState.renderMethod, _uiState.instanceDataSource)) {
+    ImGui::TextDisabled("Vertex attributes draw every instance with LOD 0");
+  }
+  if (_uiState.renderInfo.shadowsAvailable) {
+    ImGui::Checkbox("Cascaded Shadows", &_uiState.shadows);
+  } else {
+    ImGui::TextDisabled("Cascaded shadows unavailable (needs gl_Layer in vertex shaders)");
+  }
+
   ImGui::Separator();
 
   // Instance count control
@@ -91,17 +193,197 @@ void UIManager::_renderControlPanel() {
     _onSphereParamsChanged(_uiState.sphereRadius, _uiState.sphereSegments);
   }
 
+  // Sphere topology selection, matched to the silhouette error of the segments
+  int currentTopologyIndex = static_cast<int>(_uiState.sphereTopology);
+  if (ImGui::Combo("Sphere Topology", &currentTopologyIndex, SPHERE_TOPOLOGY_NAMES, IM_ARRAYSIZE(SPHERE_TOPOLOGY_NAMES))) {
+    _uiState.sphereTopology = static_cast<SphereTopology>(currentTopologyIndex);
+    if (_onSphereTopologyChanged) {
+      _onSphereTopologyChanged(_uiState.sphereTopology);
+    }
+  }
+  if (_uiState.renderMethod == RenderMethod::VERTEX_PULLING && _uiState.sphereTopology != SphereTopology::UV) {
+    ImGui::TextDisabled("Vertex pulling always generates a UV sphere");
+  }
+  if (_uiState.renderMethod == RenderMethod::TESSELLATION) {
+    ImGui::TextDisabled("Tessellation refines an octahedron by screen size, segments and topology have no effect");
+  }
+
+  // Vertex format selection
+  int currentFormatIndex = static_cast<int>(_uiState.vertexFormat);
+  if (ImGui::Combo("Vertex Format", &currentFormatIndex, VERTEX_FORMAT_NAMES, IM_ARRAYSIZE(VERTEX_FORMAT_NAMES))) {
+    _uiState.vertexFormat = static_cast<VertexFormat>(currentFormatIndex);
+    if (_onVertexFormatChanged) {
+      _onVertexFormatChanged(_uiState.vertexFormat);
+    }
+  }
+  if (_uiState.renderMethod == RenderMethod::VERTEX_PULLING || _uiState.renderMethod == RenderMethod::TESSELLATION) {
+    ImGui::TextDisabled("Vertices are generated on the GPU, format has no effect");
+  }
+
   ImGui::Separator();
 
   _renderPerformanceInfo();
 
+  ImGui::Separator();
+
+  _renderFramePipelineInfo();
+
+  ImGui::Separator();
+
+  _renderAdaptiveQuality();
+
+  ImGui::Separator();
+
+  _renderPipelineStatistics();
+
+  ImGui::Separator();
+
+  _renderGLCallCounts();
+
+  // Captures everything needed to replay this frame with --scene
+  ImGui::Separator();
+  if (_onSaveScene) {
+    if (ImGui::Button("Save Scene Snapshot")) {
+      _onSaveScene();
+    }
+  } else {
+    ImGui::TextDisabled("Scene snapshots are unavailable with the render thread");
+  }
+
+#ifdef ENABLE_PROFILER
+  ImGui::Separator();
+  if (ImGui::Button("Dump CPU Trace") && _onDumpTrace) {
+    _onDumpTrace();
+  }
+#endif
+
   ImGui::End();
 }
 
 void UIManager::_renderPerformanceInfo() {
   ImGui::Text("Performance Info:");
-  ImGui::Text("Vertices per sphere: %u", _uiState.vertexCount / _uiState.currentInstanceCount);
-  ImGui::Text("Triangles per sphere: %u", _uiState.triangleCount / _uiState.currentInstanceCount);
-  ImGui::Text("Total vertices: %u", _uiState.vertexCount);
-  ImGui::Text("Total triangles: %u", _uiState.triangleCount);
-}
\ No newline at end of file
+  ImGui::Text("Vertices per sphere: %u", _uiState.renderInfo.vertexCount / _uiState.currentInstanceCount);
+  ImGui::Text("Triangles per sphere: %u", _uiState.renderInfo.triangleCount / _uiState.currentInstanceCount);
+  ImGui::Text("Total vertices: %u", _uiState.renderInfo.vertexCount);
+  ImGui::Text("Total triangles: %u", _uiState.renderInfo.triangleCount);
+  ImGui::Text("Vertex buffer: %.1f KB (%u B/vertex)", _uiState.renderInfo.vertexBufferBytes / 1024.0, getVertexStride(_uiState.vertexFormat));
+  if (_uiState.renderMethod == RenderMethod::CLUSTER_CULLING) {
+    ImGui::Text("Clusters per sphere: %u (up to %u triangles)", _uiState.renderInfo.sphereClusterCount, ClusterCuller::MAX_CLUSTER_TRIANGLES);
+  }
+
+  ImGui::Separator();
+  ImGui::Text("Instance buffers: %.1f / %.1f KB (%u allocations)", _uiState.renderInfo.instanceBufferBytes / 1024.0,
+              _uiState.renderInfo.instanceBufferCapacityBytes / 1024.0, _uiState.renderInfo.instanceBufferAllocations);
+  ImGui::Text("Instance uploads: %u (%.2f MB total)", _uiState.renderInfo.instanceUploadCount, _uiState.renderInfo.instanceUploadedBytes / (1024.0 * 1024.0));
+  ImGui::Text("GPU buffers: %.2f MB (peak %.2f MB, %u allocations)", _uiState.renderInfo.gpuBufferBytes / (1024.0 * 1024.0),
+              _uiState.renderInfo.gpuBufferPeakBytes / (1024.0 * 1024.0), _uiState.renderInfo.gpuBufferAllocations);
+}
+
+void UIManager::_renderFramePipelineInfo() {
+  const FramePipelineStats& stats = _uiState.renderInfo.framePipelineStats;
+  ImGui::Text("Frame Preparation:");
+  ImGui::Text("Visible instances: %u / %d", stats.visibleCount, _uiState.currentInstanceCount);
+  ImGui::Text("Per LOD: %u / %u / %u", stats.lodCounts[0], stats.lodCounts[1], stats.lodCounts[2]);
+  ImGui::Text("Prepare time: %.3f ms (sort %.3f ms)", stats.prepareMs, stats.sortMs);
+  ImGui::Text("Main thread wait: %.3f ms (fence %.3f ms)", stats.waitMs, stats.fenceWaitMs);
+  ImGui::Text("Frame buffers: %s", _uiState.renderInfo.persistentlyMapped ? "persistently mapped" : "uploaded");
+  ImGui::Text("Frame arena: %.1f KB", stats.arenaBytes / 1024.0);
+  ImGui::Text("Heap allocations per frame: %llu (%llu B)", static_cast<unsigned long long>(_uiState.renderInfo.heapAllocationsPerFrame),
+              static_cast<unsigned long long>(_uiState.renderInfo.heapBytesPerFrame));
+  const GLStateCacheStats& binds = _uiState.renderInfo.stateCacheStats;
+  ImGui::Text("GL binds per frame: %u issued, %u skipped", binds.issued, binds.skipped);
+}
+
+void UIManager::_renderAdaptiveQuality() {
+  const UIRenderInfo& info = _uiState.renderInfo;
+  ImGui::Checkbox("Adaptive Quality", &_uiState.adaptiveQuality);
+  ImGui::SliderFloat("Target Frame Time", &_uiState.targetFrameTimeMs, 4.0f, 50.0f, "%.1f ms");
+  ImGui::SliderFloat("Render Scale", &_uiState.renderScale, MIN_USER_RENDER_SCALE, 1.0f, "%.2f");
+  ImGui::Text("Render resolution: %d x %d", info.renderWidth, info.renderHeight);
+  ImGui::Text("CPU frame: %.3f ms, GPU frame: %.3f ms", info.cpuFrameMs, info.gpuFrameMs);
+  if (_uiState.shadows && info.shadowsAvailable) {
+    ImGui::Text("Shadow pass: %.3f ms GPU", info.shadowGpuMs);
+  }
+  if (_uiState.adaptiveQuality) {
+    ImGui::Text("Adaptive LOD bias: %.2f, render scale: %.2f (%u adjustments)", info.adaptiveLodBias, info.adaptiveRenderScale, info.qualityAdjustments);
+  }
+}
+
+void UIManager::_renderPipelineStatistics() {
+  ImGui::Text("Pipeline Statistics (last frame):");
+  if (!_uiState.renderInfo.pipelineStatisticsSupported) {
+    ImGui::TextDisabled("ARB_pipeline_statistics_query not supported");
+    return;
+  }
+
+  // One row per method that has been rendered at least once
+  if (ImGui::BeginTable("PipelineStatistics", 7)) {
+    ImGui::TableSetupColumn("Method");
+    ImGui::TableSetupColumn("Vertices");
+    ImGui::TableSetupColumn("VS inv.");
+    ImGui::TableSetupColumn("Clip in");
+    ImGui::TableSetupColumn("Clip out");
+    ImGui::TableSetupColumn("FS inv.");
+    ImGui::TableSetupColumn("TES inv.");
+    ImGui::TableHeadersRow();
+
+    for (int i = 0; i < RENDER_METHOD_COUNT; ++i) {
+      const PipelineStatisticsResult& result = _uiState.renderInfo.pipelineStatistics[i];
+      if (!result.valid) {
+        continue;
+      }
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", RENDER_METHOD_NAMES[i]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)result.verticesSubmitted);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)result.vertexShaderInvocations);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)result.clippingInputPrimitives);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)result.clippingOutputPrimitives);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)result.fragmentShaderInvocations);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)result.tessEvaluationInvocations);
+    }
+    ImGui::EndTable();
+  }
+}
+
+void UIManager::_renderGLCallCounts() {
+  ImGui::Text("GL Calls (last frame):");
+  if (!GLCallCounter::isEnabled()) {
+    ImGui::TextDisabled("Build with -DENABLE_GL_CALL_COUNTING=ON");
+    return;
+  }
+
+  const GLCallFrameStats& stats = _uiState.renderInfo.glCallStats;
+  ImGui::Text("%llu calls, %llu draws, %.1f KB uploaded", (unsigned long long)stats.calls, (unsigned long long)stats.draws, stats.uploadBytes / 1024.0);
+
+  // Entry points called this frame, in list order
+  if (ImGui::BeginTable("GLCalls", 4)) {
+    ImGui::TableSetupColumn("Entry point");
+    ImGui::TableSetupColumn("Calls");
+    ImGui::TableSetupColumn("Draws");
+    ImGui::TableSetupColumn("Bytes");
+    ImGui::TableHeadersRow();
+
+    for (const GLEntryPointCount& count : stats.entryPoints) {
+      if (count.calls == 0) {
+        continue;
+      }
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", count.name);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)count.calls);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)count.draws);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", (unsigned long long)count.bytes);
+    }
+    ImGui::EndTable();
+  }
+}
@@ -1,16 +1,94 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include "../geo/Sphere.h"
+#include "../renderer/DepthSortMode.h"
+#include "../renderer/FramePipeline.h"
+#include "../renderer/GLStateCache.h"
+#include "../renderer/InstanceDataSource.h"
+#include "../renderer/PipelineStatistics.h"
 #include "../renderer/RenderMethod.h"
+#include "../renderer/VertexFormat.h"
+#include "../utils/GLCallCounter.h"
 
 // Forward declarations
 struct GLFWwindow;
-struct SphereGeometry;
+struct ImDrawData;
 
 // UI callback types
 using InstanceCountCallback = std::function<void(int)>;
 using SphereParamsCallback = std::function<void(float radius, int segments)>;
 using RenderMethodCallback = std::function<void(RenderMethod)>;
+using InstanceDataSourceCallback = std::function<void(InstanceDataSource)>;
+using VertexFormatCallback = std::function<void(VertexFormat)>;
+using SphereTopologyCallback = std::function<void(SphereTopology)>;
+using DumpTraceCallback = std::function<void()>;
+using SaveSceneCallback = std::function<void()>;
+
+// Statistics produced by the renderer for display
+struct UIRenderInfo
+{
+    // Performance info
+    unsigned int vertexCount = 0;
+    unsigned int triangleCount = 0;
+    size_t vertexBufferBytes = 0;  // All sphere LODs, in the current vertex format
+    unsigned int sphereClusterCount = 0;  // Clusters of the full-detail sphere
+
+    // Frame pipeline info
+    FramePipelineStats framePipelineStats;
+    bool persistentlyMapped = false;
+
+    // Instance buffer info
+    size_t instanceBufferBytes = 0;
+    size_t instanceBufferCapacityBytes = 0;
+    unsigned int instanceBufferAllocations = 0;
+    uint64_t instanceUploadedBytes = 0;
+    unsigned int instanceUploadCount = 0;
+
+    // Growable GPU buffers, all users together
+    size_t gpuBufferBytes = 0;
+    size_t gpuBufferPeakBytes = 0;
+    unsigned int gpuBufferAllocations = 0;
+
+    // Heap allocations made during the last frame, all threads
+    uint64_t heapAllocationsPerFrame = 0;
+    uint64_t heapBytesPerFrame = 0;
+
+    // Program, vertex array, buffer and texture binds of the last frame
+    GLStateCacheStats stateCacheStats;
+
+    // GL calls of the last frame per entry point, empty unless built with ENABLE_GL_CALL_COUNTING
+    GLCallFrameStats glCallStats;
+
+    // Frame timing and adaptive quality
+    double cpuFrameMs = 0.0;
+    double gpuFrameMs = 0.0;
+    double shadowGpuMs = 0.0;  // Shadow pass alone, included in gpuFrameMs
+    bool shadowsAvailable = false;
+    float adaptiveLodBias = 0.0f;
+    float adaptiveRenderScale = 1.0f;
+    int renderWidth = 0;  // Scene resolution before the upscale
+    int renderHeight = 0;
+    unsigned int qualityAdjustments = 0;
+
+    // GPU pipeline statistics, per render method
+    bool pipelineStatisticsSupported = false;
+    PipelineStatisticsResult pipelineStatistics[RENDER_METHOD_COUNT];
+};
+
+// Copy of one frame's ImGui draw data, owned so it can be rendered on another thread
+struct UIDrawSnapshot
+{
+    UIDrawSnapshot();
+    ~UIDrawSnapshot();
+
+    UIDrawSnapshot(const UIDrawSnapshot&) = delete;
+    UIDrawSnapshot& operator=(const UIDrawSnapshot&) = delete;
+
+    ImDrawData* drawData;
+};
 
 struct UIState
 {
@@ -19,11 +97,24 @@ struct UIState
     int maxInstanceCount = 100000;
     float sphereRadius = 0.02f;
     int sphereSegments = 16;
+    SphereTopology sphereTopology = SphereTopology::UV;
     RenderMethod renderMethod = RenderMethod::INSTANCED;
+    InstanceDataSource instanceDataSource = InstanceDataSource::SSBO;
+    VertexFormat vertexFormat = VertexFormat::FLOAT32;
+    DepthSortMode depthSortMode = DepthSortMode::NONE;
 
-    // Performance info
-    unsigned int vertexCount = 0;
-    unsigned int triangleCount = 0;
+    // Frame preparation
+    bool pipelinedFrames = true;
+    bool frustumCulling = false;
+    bool lodSelection = false;
+    float lodBias = 0.0f;
+    bool adaptiveQuality = false;
+    float targetFrameTimeMs = 16.6f;
+    float renderScale = 1.0f;  // Scene resolution relative to the window, upscaled below 1
+    bool shadows = false;      // Cascaded shadow map pass before the main pass
+
+    // Statistics from the renderer, display only
+    UIRenderInfo renderInfo;
 };
 
 class UIManager
@@ -39,6 +130,11 @@ public:
     void newFrame();
     void render();
 
+    // Render thread mode: every ImGui call, the backend NewFrames included, happens in buildFrame on the
+    // input thread; renderDrawData only draws the snapshot's deep copy on the GL thread
+    void buildFrame(UIDrawSnapshot& snapshot);
+    void renderDrawData(const UIDrawSnapshot& snapshot);
+
     // State management
     void setUIState(const UIState& state)
     {
@@ -62,9 +158,32 @@ public:
     {
         _onRenderMethodChanged = callback;
     }
+    void setInstanceDataSourceCallback(InstanceDataSourceCallback callback)
+    {
+        _onInstanceDataSourceChanged = callback;
+    }
+    void setVertexFormatCallback(VertexFormatCallback callback)
+    {
+        _onVertexFormatChanged = callback;
+    }
+    void setSphereTopologyCallback(SphereTopologyCallback callback)
+    {
+        _onSphereTopologyChanged = callback;
+    }
+    void setDumpTraceCallback(DumpTraceCallback callback)
+    {
+        _onDumpTrace = callback;
+    }
+    void setSaveSceneCallback(SaveSceneCallback callback)
+    {
+        _onSaveScene = callback;
+    }
 
     // Update performance info
-    void updatePerformanceInfo(const SphereGeometry& geometry, int instanceCount);
+    void setRenderInfo(const UIRenderInfo& info)
+    {
+        _uiState.renderInfo = info;
+    }
 
 private:
     UIState _uiState;
@@ -74,8 +193,17 @@ private:
     InstanceCountCallback _onInstanceCountChanged;
     SphereParamsCallback _onSphereParamsChanged;
     RenderMethodCallback _onRenderMethodChanged;
+    InstanceDataSourceCallback _onInstanceDataSourceChanged;
+    VertexFormatCallback _onVertexFormatChanged;
+    SphereTopologyCallback _onSphereTopologyChanged;
+    DumpTraceCallback _onDumpTrace;
+    SaveSceneCallback _onSaveScene;
 
     // Helper methods
     void _renderControlPanel();
     void _renderPerformanceInfo();
+    void _renderFramePipelineInfo();
+    void _renderAdaptiveQuality();
+    void _renderPipelineStatistics();
+    void _renderGLCallCounts();
 };
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Counts heap allocations made through operator new on any thread, for spotting allocations
+// in the frame loop. AllocationCounter.cpp replaces the global operator new and delete; counting
+// is one relaxed atomic increment per allocation. Allocations made with malloc (ImGui) are not seen.
+class AllocationCounter
+{
+public:
+    static uint64_t getAllocationCount();
+    static uint64_t getAllocatedBytes();
+};
+
+#endif  // ALLOCATIONCOUNTER_H
@@ -0,0 +1,40 @@
+#include "FrameArena.h"
+
+#include <cstdint>
+
+FrameArena::FrameArena(size_t initialCapacity)
+    : _block(new unsigned char[initialCapacity]), _capacity(initialCapacity), _offset(0), _overflowBytes(0), _growCount(0)
+{
+}
+
+void FrameArena::reset()
+{
+    // Grow once to last frame's total so the overflow does not repeat
+    if (_overflowBytes > 0)
+    {
+        size_t capacity = (_offset + _overflowBytes) * 2;
+        _block.reset(new unsigned char[capacity]);
+        _capacity = capacity;
+        _overflow.clear();
+        _overflowBytes = 0;
+        _growCount++;
+    }
+    _offset = 0;
+}
+
+void* FrameArena::_allocateBytes(size_t bytes, size_t alignment)
+{
+    uintptr_t base = reinterpret_cast<uintptr_t>(_block.get());
+    uintptr_t aligned = (base + _offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    size_t end = static_cast<size_t>(aligned - base) + bytes;
+    if (end <= _capacity)
+    {
+        _offset = end;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Out of room for this frame, operator new[] alignment covers every fundamental type
+    _overflow.emplace_back(new unsigned char[bytes > 0 ? bytes : 1]);
+    _overflowBytes += bytes + alignment;
+    return _overflow.back().get();
+}
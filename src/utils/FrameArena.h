@@ -0,0 +1,71 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for per-frame temporaries, freed all at once by reset().
+// Requests that do not fit the block get their own heap chunk for the rest of the frame,
+// and the next reset grows the block to cover them, so a steady workload stops allocating.
+// Not thread safe: one arena per thread that prepares frames.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Invalidates every pointer handed out since the previous reset
+    void reset();
+
+    // Uninitialized storage for count objects; only trivially destructible types, nothing is destroyed
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        return static_cast<T*>(_allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    template <typename T>
+    T* allocateFilled(size_t count, const T& value)
+    {
+        T* items = allocate<T>(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            new (&items[i]) T(value);
+        }
+        return items;
+    }
+
+    size_t getUsedBytes() const
+    {
+        return _offset + _overflowBytes;
+    }
+    size_t getCapacity() const
+    {
+        return _capacity;
+    }
+    unsigned int getGrowCount() const
+    {
+        return _growCount;
+    }
+
+private:
+    std::unique_ptr<unsigned char[]> _block;
+    size_t _capacity;
+    size_t _offset;
+
+    // Requests that missed the block this frame
+    std::vector<std::unique_ptr<unsigned char[]>> _overflow;
+    size_t _overflowBytes;
+    unsigned int _growCount;
+
+    // Helper methods
+    void* _allocateBytes(size_t bytes, size_t alignment);
+};
+
+#endif  // FRAMEARENA_H
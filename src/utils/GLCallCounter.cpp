@@ -0,0 +1,170 @@
+#include "GLCallCounter.h"
+
+#ifdef ENABLE_GL_CALL_COUNTING
+
+#include <tuple>
+#include <GL/glew.h>
+
+namespace GLCallCounter
+{
+namespace
+{
+enum class CountKind
+{
+    CALL,
+    DRAW,
+    MULTI_DRAW,  // Argument is the draw count
+    UPLOAD       // Argument is the byte size, the data pointer follows it
+};
+
+// GLEW name without the gl prefix, what a call counts besides itself, and the argument it reads
+#define GL_COUNTED_ENTRY_POINTS(X)                         \
+    X(UseProgram, CALL, 0)                                 \
+    X(BindVertexArray, CALL, 0)                            \
+    X(BindBuffer, CALL, 0)                                 \
+    X(BindBufferBase, CALL, 0)                             \
+    X(ActiveTexture, CALL, 0)                              \
+    X(BindFramebuffer, CALL, 0)                            \
+    X(BlitFramebuffer, CALL, 0)                            \
+    X(TexBuffer, CALL, 0)                                  \
+    X(GetUniformLocation, CALL, 0)                         \
+    X(Uniform1i, CALL, 0)                                  \
+    X(Uniform1f, CALL, 0)                                  \
+    X(Uniform1ui, CALL, 0)                                 \
+    X(Uniform1iv, CALL, 0)                                 \
+    X(Uniform1uiv, CALL, 0)                                \
+    X(Uniform2uiv, CALL, 0)                                \
+    X(Uniform3fv, CALL, 0)                                 \
+    X(Uniform4fv, CALL, 0)                                 \
+    X(UniformMatrix4fv, CALL, 0)                           \
+    X(GenBuffers, CALL, 0)                                 \
+    X(DeleteBuffers, CALL, 0)                              \
+    X(BufferData, UPLOAD, 1)                               \
+    X(BufferSubData, UPLOAD, 2)                            \
+    X(BufferStorage, UPLOAD, 1)                            \
+    X(MapBufferRange, CALL, 0)                             \
+    X(UnmapBuffer, CALL, 0)                                \
+    X(FenceSync, CALL, 0)                                  \
+    X(ClientWaitSync, CALL, 0)                             \
+    X(DeleteSync, CALL, 0)                                 \
+    X(BeginQuery, CALL, 0)                                 \
+    X(EndQuery, CALL, 0)                                   \
+    X(GetQueryObjectuiv, CALL, 0)                          \
+    X(GetQueryObjectui64v, CALL, 0)                        \
+    X(DrawElementsInstanced, DRAW, 0)                      \
+    X(DrawElementsInstancedBaseVertex, DRAW, 0)            \
+    X(DrawElementsInstancedBaseVertexBaseInstance, DRAW, 0) \
+    X(DrawArraysInstancedBaseInstance, DRAW, 0)            \
+    X(MultiDrawElementsBaseVertex, MULTI_DRAW, 4)          \
+    X(MultiDrawElementsIndirect, MULTI_DRAW, 3)            \
+    X(DispatchCompute, CALL, 0)                            \
+    X(MemoryBarrier, CALL, 0)                              \
+    X(VertexAttribPointer, CALL, 0)                        \
+    X(VertexAttribDivisor, CALL, 0)
+
+enum EntryPoint
+{
+#define GL_COUNTED_ENUM(suffix, kind, argument) ENTRY_##suffix,
+    GL_COUNTED_ENTRY_POINTS(GL_COUNTED_ENUM)
+#undef GL_COUNTED_ENUM
+    ENTRY_COUNT
+};
+static_assert(ENTRY_COUNT == GL_COUNTED_ENTRY_POINT_COUNT, "GL_COUNTED_ENTRY_POINT_COUNT must match the entry point list");
+
+// GL calls come from the one thread owning the context, plain counters suffice
+GLCallFrameStats g_current;
+GLCallFrameStats g_lastFrame;
+
+template <CountKind Kind, int Argument, typename... Args>
+void account(GLEntryPointCount& count, Args... args)
+{
+    count.calls++;
+    if constexpr (Kind == CountKind::DRAW)
+    {
+        count.draws++;
+    }
+    else if constexpr (Kind == CountKind::MULTI_DRAW)
+    {
+        count.draws += static_cast<uint64_t>(std::get<Argument>(std::forward_as_tuple(args...)));
+    }
+    else if constexpr (Kind == CountKind::UPLOAD)
+    {
+        // Without data glBufferData and glBufferStorage only allocate
+        auto arguments = std::forward_as_tuple(args...);
+        if (std::get<Argument + 1>(arguments) != nullptr)
+        {
+            count.bytes += static_cast<uint64_t>(std::get<Argument>(arguments));
+        }
+    }
+}
+
+// One wrapper per entry point, forwarding to the pointer GLEW loaded
+template <int Entry, CountKind Kind, int Argument, typename Function>
+struct Wrapper;
+
+template <int Entry, CountKind Kind, int Argument, typename Result, typename... Args>
+struct Wrapper<Entry, Kind, Argument, Result(GLAPIENTRY*)(Args...)>
+{
+    static Result(GLAPIENTRY* original)(Args...);
+
+    static Result GLAPIENTRY call(Args... args)
+    {
+        account<Kind, Argument>(g_current.entryPoints[Entry], args...);
+        return original(args...);
+    }
+};
+
+template <int Entry, CountKind Kind, int Argument, typename Result, typename... Args>
+Result(GLAPIENTRY* Wrapper<Entry, Kind, Argument, Result(GLAPIENTRY*)(Args...)>::original)(Args...) = nullptr;
+
+template <typename EntryWrapper, typename Function>
+void installWrapper(Function& pointer, int entry, const char* name)
+{
+    g_current.entryPoints[entry].name = name;
+    g_lastFrame.entryPoints[entry].name = name;
+
+    // Entry points the driver lacks stay null, installing twice must not wrap the wrapper
+    if (pointer != nullptr && pointer != &EntryWrapper::call)
+    {
+        EntryWrapper::original = pointer;
+        pointer = &EntryWrapper::call;
+    }
+}
+}  // namespace
+
+void install()
+{
+#define GL_COUNTED_INSTALL(suffix, kind, argument) \
+    installWrapper<Wrapper<ENTRY_##suffix, CountKind::kind, argument, decltype(__glew##suffix)>>(__glew##suffix, ENTRY_##suffix, "gl" #suffix);
+    GL_COUNTED_ENTRY_POINTS(GL_COUNTED_INSTALL)
+#undef GL_COUNTED_INSTALL
+}
+
+void beginFrame()
+{
+    g_current.calls = 0;
+    g_current.draws = 0;
+    g_current.uploadBytes = 0;
+    for (const GLEntryPointCount& count : g_current.entryPoints)
+    {
+        g_current.calls += count.calls;
+        g_current.draws += count.draws;
+        g_current.uploadBytes += count.bytes;
+    }
+    g_lastFrame = g_current;
+
+    for (GLEntryPointCount& count : g_current.entryPoints)
+    {
+        count.calls = 0;
+        count.draws = 0;
+        count.bytes = 0;
+    }
+}
+
+const GLCallFrameStats& getLastFrame()
+{
+    return g_lastFrame;
+}
+}  // namespace GLCallCounter
+
+#endif  // ENABLE_GL_CALL_COUNTING
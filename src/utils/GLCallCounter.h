@@ -0,0 +1,70 @@
+#ifndef GLCALLCOUNTER_H
+#define GLCALLCOUNTER_H
+
+// Per-frame counts of GL calls, draws and uploaded bytes per entry point.
+// Build with -DENABLE_GL_CALL_COUNTING=ON; install() then swaps the GLEW function pointers for
+// counting wrappers. Otherwise every function is an empty inline and GL calls go straight to the driver.
+// GL 1.1 entry points (glDrawElements, glClear, glBindTexture...) are not loaded through GLEW and are not seen.
+
+#include <cstdint>
+
+// Entry points wrapped by the counting build, see GLCallCounter.cpp
+const int GL_COUNTED_ENTRY_POINT_COUNT = 42;
+
+struct GLEntryPointCount
+{
+    const char* name = "";
+    uint64_t calls = 0;
+    uint64_t draws = 0;  // Draws issued, a multi-draw counts each of its commands
+    uint64_t bytes = 0;  // Bytes passed to buffer uploads, allocations without data count none
+};
+
+struct GLCallFrameStats
+{
+    uint64_t calls = 0;
+    uint64_t draws = 0;
+    uint64_t uploadBytes = 0;
+    GLEntryPointCount entryPoints[GL_COUNTED_ENTRY_POINT_COUNT];
+};
+
+#ifdef ENABLE_GL_CALL_COUNTING
+
+namespace GLCallCounter
+{
+constexpr bool isEnabled()
+{
+    return true;
+}
+
+// Call after glewInit, again after any later glewInit
+void install();
+
+// Closes the counts since the previous call as the last frame and starts a new one
+void beginFrame();
+
+const GLCallFrameStats& getLastFrame();
+}  // namespace GLCallCounter
+
+#else
+
+namespace GLCallCounter
+{
+constexpr bool isEnabled()
+{
+    return false;
+}
+
+inline void install() {}
+
+inline void beginFrame() {}
+
+inline const GLCallFrameStats& getLastFrame()
+{
+    static const GLCallFrameStats empty;
+    return empty;
+}
+}  // namespace GLCallCounter
+
+#endif  // ENABLE_GL_CALL_COUNTING
+
+#endif  // GLCALLCOUNTER_H
@@ -0,0 +1,43 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first touch,
+// so only the parts actually read (or handed to the driver for upload) come off disk.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const
+    {
+        return _data != nullptr;
+    }
+    const unsigned char* getData() const
+    {
+        return static_cast<const unsigned char*>(_data);
+    }
+    size_t getSize() const
+    {
+        return _size;
+    }
+
+private:
+    void* _data;
+    size_t _size;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#endif
+};
+
+#endif  // MAPPEDFILE_H
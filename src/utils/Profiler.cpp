@@ -0,0 +1,123 @@
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Profiler
+{
+namespace
+{
+struct ZoneEvent
+{
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Written only by its owning thread; the dump reads up to the published write index
+struct ThreadBuffer
+{
+    static const size_t CAPACITY = 1 << 16;  // Power of two, oldest zones are overwritten
+
+    ZoneEvent events[CAPACITY];
+    std::atomic<uint64_t> writeIndex{0};
+    uint32_t threadId = 0;
+};
+
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+// Registry of all thread buffers. Locked once per thread on first use and by the dump,
+// never on the recording path. Buffers are never freed so a dump can outlive threads.
+std::mutex g_registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_threadBuffers;
+
+ThreadBuffer* registerThread()
+{
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    g_threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer* buffer = g_threadBuffers.back().get();
+    buffer->threadId = static_cast<uint32_t>(g_threadBuffers.size());
+    return buffer;
+}
+
+ThreadBuffer& threadBuffer()
+{
+    thread_local ThreadBuffer* buffer = registerThread();
+    return *buffer;
+}
+
+void writeEscaped(std::ostream& out, const char* text)
+{
+    for (const char* c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out << '\\';
+        }
+        out << *c;
+    }
+}
+}  // namespace
+
+uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void record(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+    buffer.events[index & (ThreadBuffer::CAPACITY - 1)] = ZoneEvent{name, startNs, endNs};
+    buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+bool writeChromeTrace(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    size_t eventCount = 0;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : g_threadBuffers)
+    {
+        // Zones still being recorded by other threads may be overwritten mid-dump; they are just dropped
+        uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+        uint64_t begin = end > ThreadBuffer::CAPACITY ? end - ThreadBuffer::CAPACITY : 0;
+
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            const ZoneEvent& event = buffer->events[i & (ThreadBuffer::CAPACITY - 1)];
+            out << (first ? "\n" : ",\n") << "{\"name\":\"";
+            writeEscaped(out, event.name);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":" << event.startNs / 1000.0
+                << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << "}";
+            first = false;
+            eventCount++;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    std::cout << "Wrote " << eventCount << " CPU zones to " << path << std::endl;
+    return out.good();
+}
+}  // namespace Profiler
+
+#endif  // ENABLE_PROFILER
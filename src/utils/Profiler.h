@@ -0,0 +1,51 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped CPU timing zones with Chrome trace-event export.
+// Build with -DENABLE_PROFILER=ON; otherwise PROFILE_ZONE compiles to nothing.
+
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+#include <string>
+
+namespace Profiler
+{
+// Nanoseconds since the profiler epoch
+uint64_t now();
+
+// Append a completed zone to the calling thread's ring buffer (lock-free)
+void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+// Write every thread's buffered zones as Chrome trace-event JSON (chrome://tracing, Perfetto)
+bool writeChromeTrace(const std::string& path);
+
+class ScopedZone
+{
+public:
+    explicit ScopedZone(const char* name) : _name(name), _start(now()) {}
+    ~ScopedZone()
+    {
+        record(_name, _start, now());
+    }
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    const char* _name;  // Must be a string literal or otherwise outlive the trace dump
+    uint64_t _start;
+};
+}  // namespace Profiler
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) Profiler::ScopedZone PROFILE_CONCAT(_profileZone, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+
+#endif  // ENABLE_PROFILER
+
+#endif  // PROFILER_H
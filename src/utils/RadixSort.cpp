@@ -0,0 +1,106 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include "ThreadPool.h"
+
+namespace
+{
+// Below this a single chunk is faster than waking the pool
+const size_t PARALLEL_THRESHOLD = 16384;
+}  // namespace
+
+void RadixSorter::sort(uint32_t* keys, uint32_t* values, size_t count, int keyBits, ThreadPool* pool)
+{
+    if (count < 2 || keyBits <= 0)
+    {
+        return;
+    }
+
+    int chunkCount = (pool && count >= PARALLEL_THRESHOLD) ? static_cast<int>(pool->getThreadCount()) : 1;
+    auto chunkBegin = [count, chunkCount](int chunk) { return count * chunk / chunkCount; };
+    auto forEachChunk = [pool, chunkCount](const auto& task)
+    {
+        if (chunkCount > 1)
+        {
+            pool->parallelFor(chunkCount, task);
+        }
+        else
+        {
+            task(0);
+        }
+    };
+
+    _keyScratch.resize(count);
+    _valueScratch.resize(count);
+    _histograms.resize(static_cast<size_t>(chunkCount) * RADIX);
+
+    uint32_t* srcKeys = keys;
+    uint32_t* srcValues = values;
+    uint32_t* dstKeys = _keyScratch.data();
+    uint32_t* dstValues = _valueScratch.data();
+
+    for (int shift = 0; shift < keyBits; shift += RADIX_BITS)
+    {
+        // Per-chunk digit histograms
+        forEachChunk([&](int chunk)
+                     {
+                         size_t* histogram = &_histograms[static_cast<size_t>(chunk) * RADIX];
+                         std::fill(histogram, histogram + RADIX, 0);
+                         size_t end = chunkBegin(chunk + 1);
+                         for (size_t i = chunkBegin(chunk); i < end; ++i)
+                         {
+                             histogram[(srcKeys[i] >> shift) & (RADIX - 1)]++;
+                         }
+                     });
+
+        // Exclusive prefix over (digit, chunk) so each chunk scatters into its own stable range
+        bool trivialPass = false;
+        size_t offset = 0;
+        for (int digit = 0; digit < RADIX; ++digit)
+        {
+            size_t digitTotal = 0;
+            for (int chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                size_t& bucket = _histograms[static_cast<size_t>(chunk) * RADIX + digit];
+                size_t bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+                digitTotal += bucketCount;
+            }
+            if (digitTotal == count)
+            {
+                trivialPass = true;
+            }
+        }
+
+        // Every key has the same digit, the pass would not move anything
+        if (trivialPass)
+        {
+            continue;
+        }
+
+        // Scatter
+        forEachChunk([&](int chunk)
+                     {
+                         size_t* offsets = &_histograms[static_cast<size_t>(chunk) * RADIX];
+                         size_t end = chunkBegin(chunk + 1);
+                         for (size_t i = chunkBegin(chunk); i < end; ++i)
+                         {
+                             size_t destination = offsets[(srcKeys[i] >> shift) & (RADIX - 1)]++;
+                             dstKeys[destination] = srcKeys[i];
+                             dstValues[destination] = srcValues[i];
+                         }
+                     });
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+    }
+
+    // Odd number of passes leaves the result in scratch
+    if (srcKeys != keys)
+    {
+        std::memcpy(keys, srcKeys, count * sizeof(uint32_t));
+        std::memcpy(values, srcValues, count * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Stable LSD radix sort of (key, value) pairs on 8-bit digits.
+// Each pass histograms and scatters per chunk in parallel; scratch storage is kept between calls.
+class RadixSorter
+{
+public:
+    // Sorts keys ascending, permuting values alongside. Only the low keyBits of each key are considered.
+    void sort(uint32_t* keys, uint32_t* values, size_t count, int keyBits, ThreadPool* pool = nullptr);
+
+private:
+    static const int RADIX_BITS = 8;
+    static const int RADIX = 1 << RADIX_BITS;
+
+    std::vector<uint32_t> _keyScratch;
+    std::vector<uint32_t> _valueScratch;
+    std::vector<size_t> _histograms;  // [chunk][digit]
+};
+
+#endif  // RADIXSORT_H
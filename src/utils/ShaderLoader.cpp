@@ -6,19 +6,28 @@
 
 GLuint ShaderLoader::loadShader(const std::string& filePath, GLenum shaderType)
 {
-    // Read shader file
+    std::string source;
+    if (!readSource(filePath, source))
+    {
+        return 0;
+    }
+
+    return loadShaderFromSource(source, shaderType);
+}
+
+bool ShaderLoader::readSource(const std::string& filePath, std::string& source)
+{
     std::ifstream file(filePath);
     if (!file.is_open())
     {
         std::cerr << "Failed to open shader file: " << filePath << std::endl;
-        return 0;
+        return false;
     }
 
     std::ostringstream content;
     content << file.rdbuf();
-    std::string source = content.str();
-
-    return loadShaderFromSource(source, shaderType);
+    source = content.str();
+    return true;
 }
 
 GLuint ShaderLoader::loadShaderFromSource(const std::string& shaderSource, GLenum shaderType)
@@ -44,12 +53,70 @@ GLuint ShaderLoader::loadShaderFromSource(const std::string& shaderSource, GLenu
     return shader;
 }
 
+GLuint ShaderLoader::loadShaderFromSpirv(const uint32_t* words, size_t wordCount, GLenum shaderType)
+{
+    if (!isSpirvSupported() || words == nullptr || wordCount == 0)
+    {
+        return 0;
+    }
+
+    // The binary replaces the source; specialization then stands in for compilation
+    GLuint shader = glCreateShader(shaderType);
+    glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, words, static_cast<GLsizei>(wordCount * sizeof(uint32_t)));
+    glSpecializeShaderARB(shader, "main", 0, nullptr, nullptr);
+
+    GLint isCompiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+    if (!isCompiled)
+    {
+        GLchar infoLog[512];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << "SPIR-V specialization error: " << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+bool ShaderLoader::isSpirvSupported()
+{
+    return GLEW_ARB_gl_spirv;
+}
+
 GLuint ShaderLoader::createProgram(GLuint vertexShader, GLuint fragmentShader)
 {
     GLuint program = glCreateProgram();
 
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
+
+    return _linkProgram(program);
+}
+
+GLuint ShaderLoader::createComputeProgram(GLuint computeShader)
+{
+    GLuint program = glCreateProgram();
+
+    glAttachShader(program, computeShader);
+
+    return _linkProgram(program);
+}
+
+GLuint ShaderLoader::createTessellationProgram(GLuint vertexShader, GLuint controlShader, GLuint evaluationShader, GLuint fragmentShader)
+{
+    GLuint program = glCreateProgram();
+
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, controlShader);
+    glAttachShader(program, evaluationShader);
+    glAttachShader(program, fragmentShader);
+
+    return _linkProgram(program);
+}
+
+GLuint ShaderLoader::_linkProgram(GLuint program)
+{
     glLinkProgram(program);
 
     // Check linking status
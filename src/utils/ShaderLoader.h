@@ -2,6 +2,8 @@
 #define SHADERLOADER_H
 
 #include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 class ShaderLoader
@@ -9,9 +11,25 @@ class ShaderLoader
 public:
     static GLuint loadShader(const std::string& filePath, GLenum shaderType);
 
+    // Whole file as text, false and a message when it cannot be opened
+    static bool readSource(const std::string& filePath, std::string& source);
+
     static GLuint loadShaderFromSource(const std::string& shaderSource, GLenum shaderType);
 
+    // SPIR-V module specialized at main, requires ARB_gl_spirv (core in GL 4.6)
+    static GLuint loadShaderFromSpirv(const uint32_t* words, size_t wordCount, GLenum shaderType);
+
+    static bool isSpirvSupported();
+
     static GLuint createProgram(GLuint vertexShader, GLuint fragmentShader);
+
+    static GLuint createComputeProgram(GLuint computeShader);
+
+    // Vertex, tessellation control, tessellation evaluation and fragment stages
+    static GLuint createTessellationProgram(GLuint vertexShader, GLuint controlShader, GLuint evaluationShader, GLuint fragmentShader);
+
+private:
+    static GLuint _linkProgram(GLuint program);
 };
 
 #endif  // SHADERLOADER_H
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+// Items live in place: the producer fills the slot returned by beginWrite, the consumer reads
+// the slot returned by beginRead, so heavy items keep their allocations between uses.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer: free slot to fill, or nullptr when the queue is full
+    T* beginWrite()
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == Capacity)
+        {
+            return nullptr;
+        }
+        return &_items[head & (Capacity - 1)];
+    }
+
+    // Producer: publishes the slot returned by beginWrite
+    void endWrite()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest published slot, or nullptr when the queue is empty
+    T* beginRead()
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &_items[tail & (Capacity - 1)];
+    }
+
+    // Consumer: hands the slot returned by beginRead back to the producer
+    void endRead()
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: true when another slot is published after the one being read
+    bool hasNewer() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed) > 1;
+    }
+
+private:
+    // Separate cache lines so producer and consumer do not false-share
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+    T _items[Capacity];
+};
+
+#endif  // SPSCQUEUE_H
@@ -0,0 +1,120 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int workerCount)
+    : _task(nullptr), _taskCount(0), _generation(0), _stopping(false), _nextTask(0), _pendingTasks(0), _activeWorkers(0)
+{
+    if (workerCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    _workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        _workers.emplace_back([this]() { _workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeCondition.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::_parallelFor(int taskCount, const TaskRef& task)
+{
+    if (taskCount <= 0)
+    {
+        return;
+    }
+
+    // Nothing to share, run inline
+    if (_workers.empty() || taskCount == 1)
+    {
+        for (int i = 0; i < taskCount; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    // Publish the batch
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _taskCount = taskCount;
+        _nextTask.store(0, std::memory_order_relaxed);
+        _pendingTasks.store(taskCount, std::memory_order_relaxed);
+        _generation++;
+    }
+    _wakeCondition.notify_all();
+
+    // The caller helps out
+    _runTasks(task, taskCount);
+
+    // Wait for the tasks and for every worker to leave the batch, so `task` can safely go out of scope
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCondition.wait(lock, [this]() { return _pendingTasks.load(std::memory_order_acquire) == 0 && _activeWorkers == 0; });
+    _task = nullptr;
+}
+
+void ThreadPool::_workerLoop()
+{
+    unsigned int seenGeneration = 0;
+
+    while (true)
+    {
+        const TaskRef* task = nullptr;
+        int taskCount = 0;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeCondition.wait(lock, [&]() { return _stopping || (_generation != seenGeneration && _task != nullptr); });
+            if (_stopping)
+            {
+                return;
+            }
+            seenGeneration = _generation;
+            task = _task;
+            taskCount = _taskCount;
+            _activeWorkers++;
+        }
+
+        _runTasks(*task, taskCount);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _activeWorkers--;
+        }
+        _doneCondition.notify_all();
+    }
+}
+
+void ThreadPool::_runTasks(const TaskRef& task, int taskCount)
+{
+    while (true)
+    {
+        int index = _nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (index >= taskCount)
+        {
+            return;
+        }
+
+        task(index);
+
+        if (_pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Last task done, wake the caller (takes the lock so the notification cannot be missed)
+            std::lock_guard<std::mutex> lock(_mutex);
+            _doneCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel CPU kernels.
+// parallelFor blocks the caller, which also runs tasks; it must not be called from inside a task.
+class ThreadPool
+{
+public:
+    // 0 workers picks hardware_concurrency - 1 (the caller is the remaining thread)
+    explicit ThreadPool(unsigned int workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Workers plus the calling thread
+    unsigned int getThreadCount() const
+    {
+        return static_cast<unsigned int>(_workers.size()) + 1;
+    }
+
+    // Runs task(i) for every i in [0, taskCount) and returns when all have finished.
+    // The task is referenced rather than copied into a std::function, so the call never allocates.
+    template <typename Task>
+    void parallelFor(int taskCount, const Task& task)
+    {
+        _parallelFor(taskCount, TaskRef{&task, [](const void* context, int index) { (*static_cast<const Task*>(context))(index); }});
+    }
+
+private:
+    // Non-owning reference to the caller's task
+    struct TaskRef
+    {
+        const void* context;
+        void (*invoke)(const void* context, int index);
+
+        void operator()(int index) const
+        {
+            invoke(context, index);
+        }
+    };
+
+    std::vector<std::thread> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _wakeCondition;
+    std::condition_variable _doneCondition;
+
+    // Current batch, published under _mutex
+    const TaskRef* _task;
+    int _taskCount;
+    unsigned int _generation;
+    bool _stopping;
+
+    std::atomic<int> _nextTask;
+    std::atomic<int> _pendingTasks;
+    int _activeWorkers;  // Workers still inside the current batch, guarded by _mutex
+
+    // Helper methods
+    void _parallelFor(int taskCount, const TaskRef& task);
+    void _workerLoop();
+    void _runTasks(const TaskRef& task, int taskCount);
+};
+
+#endif  // THREADPOOL_H
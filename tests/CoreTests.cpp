@@ -0,0 +1,478 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "geo/Sphere.h"
+#include "renderer/Frustum.h"
+#include "renderer/InstanceAttributes.h"
+#include "renderer/InstanceDataSource.h"
+#include "renderer/InstanceGrid.h"
+#include "renderer/SceneSnapshot.h"
+#include "renderer/ShaderVariant.h"
+#include "utils/RadixSort.h"
+#include "utils/ThreadPool.h"
+#include "shaders/sphere_spirv.h"
+
+// Invariants of the GL-free code; every failed check is printed and the run exits non-zero
+
+namespace {
+int g_failures = 0;
+
+#define CHECK(condition)                                                                       \
+  do {                                                                                         \
+    if (!(condition)) {                                                                        \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #condition << std::endl; \
+      g_failures++;                                                                            \
+    }                                                                                          \
+  } while (0)
+
+const float PI = 3.14159265358979323846f;
+
+glm::vec3 position(const Vertex& vertex) {
+  return glm::vec3(vertex.x, vertex.y, vertex.z);
+}
+
+glm::vec3 normal(const Vertex& vertex) {
+  return glm::vec3(vertex.nx, vertex.ny, vertex.nz);
+}
+
+void testSphereCounts() {
+  for (int segments : {3, 8, 16, 64}) {
+    SphereGeometry sphere = Sphere::generateSphere(segments);
+    unsigned int rings = segments;
+    unsigned int sectors = segments * 2;
+
+    CHECK(sphere.vertexCount == rings * sectors);
+    CHECK(sphere.indexCount == (rings - 1) * (sectors - 1) * 6);
+    CHECK(sphere.vertices.size() == sphere.vertexCount);
+    CHECK(sphere.indices.size() == sphere.indexCount);
+
+    size_t outOfRange = std::count_if(sphere.indices.begin(), sphere.indices.end(), [&](unsigned int index) { return index >= sphere.vertexCount; });
+    CHECK(outOfRange == 0);
+  }
+}
+
+void testSphereSurface() {
+  const float radius = 2.5f;
+  SphereGeometry sphere = Sphere::generateSphere(32, radius);
+
+  // Every vertex lies on the sphere and its normal is the unit direction to it
+  size_t offSurface = 0;
+  size_t badNormals = 0;
+  for (const Vertex& vertex : sphere.vertices) {
+    if (std::abs(glm::length(position(vertex)) - radius) > 1e-4f * radius) {
+      offSurface++;
+    }
+    if (std::abs(glm::length(normal(vertex)) - 1.0f) > 1e-4f || glm::length(position(vertex) - normal(vertex) * radius) > 1e-4f * radius) {
+      badNormals++;
+    }
+  }
+  CHECK(offSurface == 0);
+  CHECK(badNormals == 0);
+}
+
+void testSphereTriangles() {
+  const float radius = 1.5f;
+  SphereGeometry sphere = Sphere::generateSphere(64, radius);
+
+  // Pole triangles collapse to lines; all others must wind the same way around the center
+  size_t outward = 0;
+  size_t inward = 0;
+  double area = 0.0;
+  for (size_t i = 0; i + 2 < sphere.indices.size(); i += 3) {
+    glm::vec3 a = position(sphere.vertices[sphere.indices[i]]);
+    glm::vec3 b = position(sphere.vertices[sphere.indices[i + 1]]);
+    glm::vec3 c = position(sphere.vertices[sphere.indices[i + 2]]);
+    glm::vec3 cross = glm::cross(b - a, c - a);
+    float length = glm::length(cross);
+    if (length < 1e-7f * radius * radius) {
+      continue;
+    }
+    area += 0.5 * length;
+    if (glm::dot(cross, a + b + c) > 0.0f) {
+      outward++;
+    } else {
+      inward++;
+    }
+  }
+  CHECK(outward > 0 || inward > 0);
+  CHECK(outward == 0 || inward == 0);
+
+  // A closed tessellation approaches the sphere's area from below
+  double sphereArea = 4.0 * PI * radius * radius;
+  CHECK(area < sphereArea);
+  CHECK(area > 0.99 * sphereArea);
+}
+
+void testPolyhedronSpheres() {
+  const float radius = 1.5f;
+  for (int frequency : {1, 2, 5, 16}) {
+    SphereGeometry icosphere = Sphere::generateIcosphere(frequency, radius);
+    SphereGeometry octasphere = Sphere::generateOctasphere(frequency, radius);
+    CHECK(icosphere.vertexCount == 10u * frequency * frequency + 2);
+    CHECK(icosphere.indexCount == 60u * frequency * frequency);
+    CHECK(octasphere.vertexCount == 4u * frequency * frequency + 2);
+    CHECK(octasphere.indexCount == 24u * frequency * frequency);
+
+    for (const SphereGeometry* sphere : {&icosphere, &octasphere}) {
+      size_t outOfRange = std::count_if(sphere->indices.begin(), sphere->indices.end(), [&](unsigned int index) { return index >= sphere->vertexCount; });
+      CHECK(outOfRange == 0);
+
+      size_t offSurface = std::count_if(sphere->vertices.begin(), sphere->vertices.end(), [&](const Vertex& vertex) {
+        return std::abs(glm::length(position(vertex)) - radius) > 1e-4f * radius || glm::length(position(vertex) - normal(vertex) * radius) > 1e-4f * radius;
+      });
+      CHECK(offSurface == 0);
+
+      // Shared vertices: every edge joins exactly two triangles, once in each direction, and all wind outward
+      std::vector<uint64_t> edges;
+      size_t inward = 0;
+      for (size_t i = 0; i + 2 < sphere->indices.size(); i += 3) {
+        for (int corner = 0; corner < 3; ++corner) {
+          uint64_t from = sphere->indices[i + corner];
+          uint64_t to = sphere->indices[i + (corner + 1) % 3];
+          edges.push_back(from << 32 | to);
+        }
+        glm::vec3 a = position(sphere->vertices[sphere->indices[i]]);
+        glm::vec3 b = position(sphere->vertices[sphere->indices[i + 1]]);
+        glm::vec3 c = position(sphere->vertices[sphere->indices[i + 2]]);
+        if (glm::dot(glm::cross(b - a, c - a), a + b + c) <= 0.0f) {
+          inward++;
+        }
+      }
+      std::sort(edges.begin(), edges.end());
+      size_t unpaired = std::count_if(edges.begin(), edges.end(), [&](uint64_t edge) {
+        uint64_t reversed = (edge & 0xffffffffu) << 32 | edge >> 32;
+        return !std::binary_search(edges.begin(), edges.end(), reversed);
+      });
+      CHECK(std::adjacent_find(edges.begin(), edges.end()) == edges.end());
+      CHECK(unpaired == 0);
+      CHECK(inward == 0);
+    }
+  }
+}
+
+void testSphereTopologies() {
+  // UV triangles wind outward too, so switching topology keeps the culled faces
+  SphereGeometry uv = Sphere::generateSphere(16);
+  size_t inward = 0;
+  for (size_t i = 0; i + 2 < uv.indices.size(); i += 3) {
+    glm::vec3 a = position(uv.vertices[uv.indices[i]]);
+    glm::vec3 b = position(uv.vertices[uv.indices[i + 1]]);
+    glm::vec3 c = position(uv.vertices[uv.indices[i + 2]]);
+    if (glm::dot(glm::cross(b - a, c - a), a + b + c) < -1e-6f) {
+      inward++;
+    }
+  }
+  CHECK(inward == 0);
+
+  for (int segments : {8, 16, 32, 64}) {
+    SphereGeometry reference = Sphere::generateSphere(segments, 2.0f);
+    float targetError = Sphere::getSilhouetteError(reference, 2.0f);
+    CHECK(targetError > 0.0f && targetError < 0.1f);
+
+    // Matched spheres are at least as accurate with fewer triangles
+    for (SphereTopology topology : {SphereTopology::ICOSPHERE, SphereTopology::OCTASPHERE}) {
+      SphereGeometry matched = Sphere::generate(topology, segments, 2.0f);
+      CHECK(Sphere::getSilhouetteError(matched, 2.0f) <= targetError);
+      CHECK(matched.indexCount < reference.indexCount);
+    }
+
+    SphereGeometry same = Sphere::generate(SphereTopology::UV, segments, 2.0f);
+    CHECK(same.indices == reference.indices);
+  }
+
+  // Finer frequencies only get closer to the sphere
+  CHECK(Sphere::getSilhouetteError(Sphere::generateIcosphere(8)) < Sphere::getSilhouetteError(Sphere::generateIcosphere(4)));
+  CHECK(Sphere::getSilhouetteError(Sphere::generateOctasphere(8)) < Sphere::getSilhouetteError(Sphere::generateOctasphere(4)));
+}
+
+void testTessellationLevels() {
+  // The tessellation control shader picks level n for an error of radius / n^2; tessellating the
+  // octahedron's faces at level n gives the octasphere of frequency n
+  for (int level : {1, 2, 3, 8, 16, 33, 64}) {
+    float error = Sphere::getSilhouetteError(Sphere::generateOctasphere(level));
+    CHECK(error * level * level <= 1.0f);
+  }
+
+  // Its own program, reading instances from the SSBO only
+  CHECK(sphereShaderVariant(RenderMethod::TESSELLATION, InstanceDataSource::TEXTURE_BUFFER, VertexFormat::SNORM16) == ShaderFeature::TESSELLATION);
+  CHECK(isInstanceDataSourceSupported(RenderMethod::TESSELLATION, InstanceDataSource::SSBO));
+  CHECK(!isInstanceDataSourceSupported(RenderMethod::TESSELLATION, InstanceDataSource::VERTEX_ATTRIBUTE));
+  CHECK(!isInstanceDataSourceSupported(RenderMethod::TESSELLATION, InstanceDataSource::TEXTURE_BUFFER));
+}
+
+void testShadowCasterVariants() {
+  // The shadow pass decodes vertices through the same source and defines as the main pass
+  for (int format = 0; format < VERTEX_FORMAT_COUNT; ++format) {
+    ShaderVariant variant = shadowCasterVariant(static_cast<VertexFormat>(format));
+    CHECK(variant.has(ShaderFeature::SHADOW_CASTER));
+    CHECK((variantFromDefines("SHADOW_CASTER") | vertexFormatVariant(static_cast<VertexFormat>(format))) == variant);
+    CHECK(sphereShaderVariant(RenderMethod::INSTANCED, InstanceDataSource::SSBO, static_cast<VertexFormat>(format)) ==
+          ShaderVariant::fromBits(variant.getBits() & ~static_cast<uint32_t>(ShaderFeature::SHADOW_CASTER)));
+  }
+}
+
+void testSpirvVariants() {
+  // Built without glslangValidator the table holds a single null entry and every variant is GLSL
+  const auto& embedded = GeneratedShaders::SPHERE_SPIRV_VARIANTS;
+  if (embedded[0].vertex == nullptr) {
+    return;
+  }
+
+  // The define sets in sphere_spirv.cmake are kept by hand; each one must name a variant that is used
+  auto isEmbedded = [&](ShaderVariant variant) {
+    return std::any_of(std::begin(embedded), std::end(embedded), [&](const GeneratedShaders::SphereSpirvVariant& spirv) { return variantFromDefines(spirv.defines) == variant; });
+  };
+  std::vector<ShaderVariant> used;
+  const int sourceCount = sizeof(INSTANCE_DATA_SOURCE_NAMES) / sizeof(INSTANCE_DATA_SOURCE_NAMES[0]);
+  for (int method = 0; method < RENDER_METHOD_COUNT; ++method) {
+    for (int source = 0; source < sourceCount; ++source) {
+      for (int format = 0; format < VERTEX_FORMAT_COUNT; ++format) {
+        ShaderVariant variant = sphereShaderVariant(static_cast<RenderMethod>(method), static_cast<InstanceDataSource>(source), static_cast<VertexFormat>(format));
+        used.push_back(variant);
+        // The tessellation stages are never embedded
+        if (!variant.has(ShaderFeature::TESSELLATION) && !isEmbedded(variant)) {
+          std::cerr << "No SPIR-V for render method " << method << ", source " << source << ", format " << format << std::endl;
+          g_failures++;
+        }
+      }
+    }
+  }
+
+  size_t unused = std::count_if(std::begin(embedded), std::end(embedded), [&](const GeneratedShaders::SphereSpirvVariant& spirv) {
+    return std::find(used.begin(), used.end(), variantFromDefines(spirv.defines)) == used.end();
+  });
+  CHECK(unused == 0);
+}
+
+void testGridLayout() {
+  const float spacing = 0.25f;
+  std::vector<glm::mat4> matrices;
+  for (int count : {1, 7, 100, 1000}) {
+    generateGridMatrices(count, spacing, matrices);
+    CHECK(matrices.size() == static_cast<size_t>(count));
+
+    int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    float offset = (gridSize - 1) * spacing * 0.5f;
+
+    // Pure translations on the y = 0 plane, one instance per grid cell
+    std::vector<bool> occupied(gridSize * gridSize, false);
+    size_t misplaced = 0;
+    for (const glm::mat4& model : matrices) {
+      glm::mat3 rotation(model);
+      glm::vec3 translation(model[3]);
+      float cellX = (translation.x + offset) / spacing;
+      float cellZ = (translation.z + offset) / spacing;
+      int x = static_cast<int>(std::lround(cellX));
+      int z = static_cast<int>(std::lround(cellZ));
+      bool valid = rotation == glm::mat3(1.0f) && translation.y == 0.0f && std::abs(cellX - x) < 1e-3f && std::abs(cellZ - z) < 1e-3f && x >= 0 &&
+                   x < gridSize && z >= 0 && z < gridSize && !occupied[z * gridSize + x];
+      if (!valid) {
+        misplaced++;
+        continue;
+      }
+      occupied[z * gridSize + x] = true;
+    }
+    CHECK(misplaced == 0);
+  }
+
+  // A full square grid is centered on the origin
+  generateGridMatrices(100, spacing, matrices);
+  glm::vec3 sum(0.0f);
+  for (const glm::mat4& model : matrices) {
+    sum += glm::vec3(model[3]);
+  }
+  CHECK(glm::length(sum / 100.0f) < 1e-4f);
+
+  // Regenerating with fewer instances replaces the contents
+  generateGridMatrices(10, spacing, matrices);
+  CHECK(matrices.size() == 10);
+}
+
+void testInstanceAttributes() {
+  // Columns are uploaded verbatim, so strides and bindings must line up with the shader blocks
+  CHECK(sizeof(INSTANCE_ATTRIBUTE_STRIDES) / sizeof(INSTANCE_ATTRIBUTE_STRIDES[0]) == static_cast<size_t>(INSTANCE_ATTRIBUTE_COUNT));
+  CHECK(sizeof(INSTANCE_ATTRIBUTE_BINDINGS) / sizeof(INSTANCE_ATTRIBUTE_BINDINGS[0]) == static_cast<size_t>(INSTANCE_ATTRIBUTE_COUNT));
+  CHECK(INSTANCE_ATTRIBUTE_BINDINGS[static_cast<int>(InstanceAttribute::MATRIX)] == 0);
+  CHECK(INSTANCE_ATTRIBUTE_BINDINGS[static_cast<int>(InstanceAttribute::MATRIX)] != INSTANCE_ATTRIBUTE_BINDINGS[static_cast<int>(InstanceAttribute::BOUNDS)]);
+
+  const InstanceAttribute matrix = InstanceAttribute::MATRIX;
+  const InstanceAttribute bounds = InstanceAttribute::BOUNDS;
+  auto isRange = [](const DirtyRange& range, size_t begin, size_t end) { return range.begin == begin && range.end == end; };
+
+  // New elements are dirty in every column
+  InstanceAttributeStore store;
+  store.resize(10);
+  CHECK(store.size() == 10);
+  CHECK(isRange(store.getDirtyRange(matrix), 0, 10));
+  CHECK(isRange(store.getDirtyRange(bounds), 0, 10));
+
+  // Dirty ranges are tracked per column and merge into one covering range
+  store.clearDirty(matrix);
+  store.clearDirty(bounds);
+  store.markDirty(matrix, 3, 5);
+  store.markDirty(matrix, 7, 8);
+  CHECK(isRange(store.getDirtyRange(matrix), 3, 8));
+  CHECK(store.getDirtyRange(bounds).empty());
+  store.markDirty(bounds, 4, 40);
+  CHECK(isRange(store.getDirtyRange(bounds), 4, 10));
+
+  // Growing adds the new elements, shrinking drops what is past the end
+  store.resize(20);
+  CHECK(isRange(store.getDirtyRange(matrix), 3, 20));
+  store.resize(6);
+  CHECK(isRange(store.getDirtyRange(matrix), 3, 6));
+  CHECK(isRange(store.getDirtyRange(bounds), 4, 6));
+
+  // Bounds are the center and the scale of the unit sphere
+  store.clearDirty(bounds);
+  glm::mat4* matrices = store.getMutable<InstanceAttribute::MATRIX>();
+  matrices[2] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, -2.0f, 3.0f)), glm::vec3(2.5f));
+  store.updateBounds(1, 3);
+  CHECK(isRange(store.getDirtyRange(bounds), 1, 3));
+  const glm::vec4* storedBounds = store.get<InstanceAttribute::BOUNDS>();
+  CHECK(glm::length(storedBounds[2] - glm::vec4(1.0f, -2.0f, 3.0f, 2.5f)) < 1e-5f);
+  CHECK(storedBounds[1] == glm::vec4(0.0f));  // Value-initialized matrix
+
+  // A borrowed column reads the caller's memory until it is written again
+  std::vector<glm::mat4> external;
+  generateGridMatrices(6, 0.5f, external);
+  store.borrow<InstanceAttribute::MATRIX>(external.data(), external.size());
+  CHECK(store.get<InstanceAttribute::MATRIX>() == external.data());
+  CHECK(store.getData(matrix) == external.data());
+  CHECK(store.getData(bounds) == store.get<InstanceAttribute::BOUNDS>());
+  store.resize(4);
+  CHECK(store.get<InstanceAttribute::MATRIX>() == external.data());
+  store.updateBounds(0, store.size());
+  CHECK(glm::vec3(store.get<InstanceAttribute::BOUNDS>()[3]) == glm::vec3(external[3][3]));
+  CHECK(store.getMutable<InstanceAttribute::MATRIX>() != external.data());
+
+  // Growing past the borrowed elements takes a copy of them, so every column always covers size()
+  store.borrow<InstanceAttribute::MATRIX>(external.data(), external.size());
+  store.resize(6);
+  CHECK(store.get<InstanceAttribute::MATRIX>() == external.data());
+  store.resize(9);
+  const glm::mat4* grown = store.get<InstanceAttribute::MATRIX>();
+  CHECK(grown != external.data());
+  CHECK(std::equal(external.begin(), external.end(), grown));
+  CHECK(grown[8] == glm::mat4(0.0f));
+
+  // The grid written in place matches the grid written to a vector
+  std::vector<glm::mat4> inPlace(6);
+  generateGridMatrices(6, 0.5f, inPlace.data());
+  CHECK(inPlace == external);
+
+  store.clear();
+  CHECK(store.size() == 0);
+  CHECK(store.getDirtyRange(matrix).empty());
+}
+
+void testFrustum() {
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::vec4 planes[6];
+  extractFrustumPlanes(projection * view, planes);
+
+  // Planes are normalized, so the tests compare distances
+  size_t unnormalized = std::count_if(std::begin(planes), std::end(planes), [](const glm::vec4& plane) { return std::abs(glm::length(glm::vec3(plane)) - 1.0f) > 1e-4f; });
+  CHECK(unnormalized == 0);
+
+  CHECK(sphereInFrustum(planes, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f));
+  CHECK(!sphereInFrustum(planes, glm::vec4(0.0f, 0.0f, 10.0f, 1.0f), 1.0f));    // Behind the camera
+  CHECK(!sphereInFrustum(planes, glm::vec4(0.0f, 0.0f, -200.0f, 1.0f), 1.0f));  // Past the far plane
+  CHECK(!sphereInFrustum(planes, glm::vec4(20.0f, 0.0f, 0.0f, 1.0f), 1.0f));
+  CHECK(sphereInFrustum(planes, glm::vec4(20.0f, 0.0f, 0.0f, 1.0f), 20.0f));  // Center outside, surface inside
+}
+
+void testSceneSnapshotResave() {
+  const std::string path = "CoreTests_snapshot.bin";
+  std::vector<glm::mat4> instances;
+  generateGridMatrices(1000, 0.1f, instances);
+  SceneSettings settings;
+  settings.sphereSegments = 24;
+  CHECK(SceneSnapshot::save(path, settings, instances.data(), instances.size()));
+
+  // Saving a loaded snapshot over its own file reads the instances from the mapping being replaced
+  SceneSnapshot loaded;
+  CHECK(loaded.load(path));
+  CHECK(loaded.getInstanceCount() == instances.size());
+  settings.sphereSegments = 32;
+  CHECK(SceneSnapshot::save(path, settings, loaded.getInstances(), loaded.getInstanceCount()));
+  CHECK(loaded.getInstances()[instances.size() - 1] == instances.back());
+
+  SceneSnapshot reloaded;
+  CHECK(reloaded.load(path));
+  CHECK(reloaded.getSettings().sphereSegments == 32);
+  CHECK(reloaded.getInstanceCount() == instances.size() && std::equal(instances.begin(), instances.end(), reloaded.getInstances()));
+
+  loaded.close();
+  reloaded.close();
+  std::remove(path.c_str());
+}
+
+void testRadixSort(ThreadPool* pool) {
+  const int keyBits = 18;
+  std::mt19937 random(1234);
+  RadixSorter sorter;
+
+  for (size_t count : {size_t(0), size_t(1), size_t(1000), size_t(100000)}) {
+    std::vector<uint32_t> originalKeys(count);
+    for (uint32_t& key : originalKeys) {
+      key = random() & ((1u << keyBits) - 1);
+    }
+    std::vector<uint32_t> keys = originalKeys;
+    std::vector<uint32_t> values(count);
+    for (size_t i = 0; i < count; ++i) {
+      values[i] = static_cast<uint32_t>(i);
+    }
+
+    sorter.sort(keys.data(), values.data(), count, keyBits, pool);
+
+    // Ascending keys, values still paired with their keys, equal keys in input order
+    size_t unordered = 0;
+    size_t unpaired = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (keys[i] != originalKeys[values[i]]) {
+        unpaired++;
+      }
+      if (i > 0 && (keys[i - 1] > keys[i] || (keys[i - 1] == keys[i] && values[i - 1] > values[i]))) {
+        unordered++;
+      }
+    }
+    CHECK(unordered == 0);
+    CHECK(unpaired == 0);
+  }
+}
+}  // namespace
+
+int main() {
+  testSphereCounts();
+  testSphereSurface();
+  testSphereTriangles();
+  testPolyhedronSpheres();
+  testSphereTopologies();
+  testTessellationLevels();
+  testShadowCasterVariants();
+  testSpirvVariants();
+  testGridLayout();
+  testInstanceAttributes();
+  testFrustum();
+  testSceneSnapshotResave();
+  testRadixSort(nullptr);
+
+  ThreadPool pool(3);
+  testRadixSort(&pool);
+
+  if (g_failures > 0) {
+    std::cerr << g_failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "All checks passed" << std::endl;
+  return 0;
+}
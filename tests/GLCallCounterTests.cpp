@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <iostream>
+#include <GL/glew.h>
+#include "utils/GLCallCounter.h"
+
+// Accounting of the GL call counter, checked against stand-in entry points so no GL context is needed
+
+namespace {
+int g_failures = 0;
+
+#define CHECK(condition)                                                                       \
+  do {                                                                                         \
+    if (!(condition)) {                                                                        \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #condition << std::endl; \
+      g_failures++;                                                                            \
+    }                                                                                          \
+  } while (0)
+
+void GLAPIENTRY fakeBufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+void GLAPIENTRY fakeBufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+void GLAPIENTRY fakeBufferStorage(GLenum, GLsizeiptr, const void*, GLbitfield) {}
+void GLAPIENTRY fakeMultiDrawElementsIndirect(GLenum, GLenum, const void*, GLsizei, GLsizei) {}
+
+void installFakes() {
+  __glewBufferData = fakeBufferData;
+  __glewBufferSubData = fakeBufferSubData;
+  __glewBufferStorage = fakeBufferStorage;
+  __glewMultiDrawElementsIndirect = fakeMultiDrawElementsIndirect;
+  GLCallCounter::install();
+  GLCallCounter::beginFrame();
+}
+
+void testUploadBytes() {
+  unsigned char data[64] = {};
+  glBufferData(GL_ARRAY_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, 32, data);
+  GLCallCounter::beginFrame();
+
+  const GLCallFrameStats& frame = GLCallCounter::getLastFrame();
+  CHECK(frame.calls == 2);
+  CHECK(frame.uploadBytes == 96);
+}
+
+void testAllocationsUploadNothing() {
+  // Storage allocated without data, as the frame pipeline and the GPU buffers do
+  glBufferData(GL_SHADER_STORAGE_BUFFER, 1 << 20, nullptr, GL_STREAM_DRAW);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, 1 << 20, nullptr, GL_MAP_WRITE_BIT);
+  GLCallCounter::beginFrame();
+
+  const GLCallFrameStats& frame = GLCallCounter::getLastFrame();
+  CHECK(frame.calls == 2);
+  CHECK(frame.uploadBytes == 0);
+}
+
+void testMultiDrawCounts() {
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 3, 0);
+  GLCallCounter::beginFrame();
+
+  const GLCallFrameStats& frame = GLCallCounter::getLastFrame();
+  CHECK(frame.calls == 1);
+  CHECK(frame.draws == 3);
+}
+}  // namespace
+
+int main() {
+  installFakes();
+  testUploadBytes();
+  testAllocationsUploadNothing();
+  testMultiDrawCounts();
+
+  if (g_failures > 0) {
+    std::cerr << g_failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "All checks passed" << std::endl;
+  return 0;
+}